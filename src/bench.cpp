@@ -0,0 +1,221 @@
+// Headless benchmark: runs the simulation without a window or GL context and
+// prints per-stage timings as JSON. Run from bin/ like the editor, e.g.
+//   ./bench --ticks 600 --bullets 1000 --cars 10000 --points 200
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <algorithm>
+
+#include "classes/logic/track_editor.h"
+#include "classes/logic/obj3dwriter.h"
+#include "classes/logic/bullet_manager.h"
+#include "classes/logic/animation_system.h"
+#include "classes/logic/stats.h"
+#include "classes/logic/scene_manifest.h"
+#include "classes/rendering/3D/scene.h"
+#include "classes/rendering/3D/render_device.h"
+
+struct BenchOptions {
+    int ticks = 600;
+    float dt = 1.0f / 60.0f;
+    int bullets = 1000;
+    int cars = 1000;
+    int points = 200;
+    unsigned threads = 1;
+    unsigned seed = 1;
+    std::string scene = "../objs/scene.rscene";
+};
+
+struct StageTiming {
+    double total_ms = 0.0;
+    double max_ms = 0.0;
+    int runs = 0;
+
+    void add(double ms) {
+        total_ms += ms;
+        max_ms = std::max(max_ms, ms);
+        runs++;
+    }
+};
+
+class StageClock {
+public:
+    StageClock(StageTiming& timing) : timing(timing), begin(std::chrono::steady_clock::now()) {}
+    ~StageClock() {
+        timing.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+    }
+
+private:
+    StageTiming& timing;
+    std::chrono::steady_clock::time_point begin;
+};
+
+bool parse_options(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--ticks") options.ticks = std::atoi(value);
+        else if (arg == "--dt") options.dt = std::atof(value);
+        else if (arg == "--bullets") options.bullets = std::atoi(value);
+        else if (arg == "--cars") options.cars = std::atoi(value);
+        else if (arg == "--points") options.points = std::atoi(value);
+        else if (arg == "--threads") options.threads = std::atoi(value);
+        else if (arg == "--seed") options.seed = std::atoi(value);
+        else if (arg == "--scene") options.scene = value;
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Closed loop around the origin with some noise, like a hand-drawn track
+std::vector<glm::vec2> make_track_points(int count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> noise(-15.0f, 15.0f);
+    std::vector<glm::vec2> points;
+    for (int i = 0; i < count; i++) {
+        float angle = glm::radians(360.0f) * i / count;
+        float radius = 100.0f + noise(rng);
+        points.push_back(glm::vec2(std::cos(angle), std::sin(angle)) * radius);
+    }
+    return points;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+    RenderDevice::set_current(std::make_unique<NullRenderDevice>());
+    std::mt19937 rng(options.seed);
+
+    // Loader messages go to stderr so stdout stays valid JSON
+    std::streambuf* stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    std::map<std::string, StageTiming> stages;
+    Scene scene;
+
+    {
+        StageClock clock(stages["load_config"]);
+        SceneManifest manifest;
+        manifest.load(options.scene);
+        for (const auto& entry : manifest.objects) {
+            auto obj = std::make_shared<Obj3D>();
+            obj->name = entry.name;
+            obj->obj_file = entry.obj_file;
+            obj->collidable = entry.collidable;
+            obj->eliminable = entry.eliminable;
+            Obj3DWriter::write(obj);
+            if (!obj->mesh) continue;
+            obj->calculate_bbox();
+            scene.add_object(obj);
+        }
+    }
+
+    TrackEditor editor;
+    auto track = std::make_shared<Obj3D>();
+    track->name = "Track";
+    track->mesh = std::make_shared<Mesh>();
+    {
+        StageClock clock(stages["track_mesh"]);
+        for (const auto& point : make_track_points(options.points, rng)) {
+            editor.add_control_point(point);
+        }
+        editor.generate_track_mesh(track->mesh);
+    }
+    {
+        StageClock clock(stages["track_upload"]);
+        track->setup_buffers();
+    }
+    scene.add_object(track);
+
+    auto path = std::make_shared<Animation>();
+    {
+        StageClock clock(stages["spline_arc_length"]);
+        path->keyframes = editor.curve_samples();
+        path->constant_speed = true;
+        path->build_arc_length_table();
+    }
+
+    // Spread the props along the track so the bullets have something to hit
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (size_t i = 0; i < scene.objects.size(); i++) {
+        if (scene.objects[i] == track) continue;
+        glm::vec3 position = path->get_position_at_time(unit(rng) * path->duration);
+        scene.objects[i]->set_transform(glm::translate(glm::mat4(1.0f), position));
+    }
+
+    AnimationSystem animation_system;
+    std::vector<std::shared_ptr<Obj3D>> cars;
+    uint32_t path_id = animation_system.add_path(path);
+    for (int i = 0; i < options.cars; i++) {
+        auto car = std::make_shared<Obj3D>();
+        cars.push_back(car);
+        animation_system.add_follower(path_id, unit(rng) * path->duration, 0.8f + 0.4f * unit(rng),
+                                      (unit(rng) - 0.5f) * editor.track_width, car);
+    }
+
+    BulletManager bullet_manager;
+    {
+        StageClock clock(stages["fire_bullets"]);
+        std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+        for (int i = 0; i < options.bullets; i++) {
+            glm::vec3 origin = path->get_position_at_time(unit(rng) * path->duration) + glm::vec3(0.0f, 0.5f, 0.0f);
+            bullet_manager.addBullet(origin, glm::vec3(direction(rng), 0.0f, direction(rng)) + glm::vec3(0.001f, 0.0f, 0.0f));
+        }
+    }
+
+    size_t peak_bullets = bullet_manager.bullets.size();
+    int64_t tick_allocations = 0;
+    int64_t collision_pairs = 0;
+    Stats::end_frame(0.0);
+    for (int tick = 0; tick < options.ticks; tick++) {
+        {
+            StageClock clock(stages["animation"]);
+            animation_system.update(options.dt, options.threads);
+            animation_system.apply_transforms();
+            scene.update_bounds();
+        }
+        {
+            StageClock clock(stages["bullets"]);
+            bullet_manager.update(options.dt);
+            bullet_manager.checkCollisions(scene);
+        }
+        scene.update();
+        peak_bullets = std::max(peak_bullets, bullet_manager.bullets.size());
+        Stats::end_frame(0.0);
+        tick_allocations += Stats::last(Stats::ALLOCATIONS);
+        collision_pairs += Stats::last(Stats::COLLISION_PAIRS);
+    }
+
+    std::cout.rdbuf(stdout_buffer);
+    std::cout << "{\n";
+    std::cout << "  \"device\": \"" << RenderDevice::current().name() << "\",\n";
+    std::cout << "  \"ticks\": " << options.ticks << ", \"dt\": " << options.dt << ", \"bullets\": " << options.bullets
+              << ", \"cars\": " << options.cars << ", \"track_points\": " << options.points
+              << ", \"threads\": " << options.threads << ", \"seed\": " << options.seed << ",\n";
+    std::cout << "  \"scene_objects\": " << scene.objects.size() << ", \"peak_bullets\": " << peak_bullets
+              << ", \"bullets_alive\": " << bullet_manager.bullets.size()
+              << ", \"bytes_uploaded\": " << RenderDevice::current().bytes_uploaded << ",\n";
+    std::cout << "  \"allocations_per_tick\": " << (double)tick_allocations / std::max(options.ticks, 1)
+              << ", \"collision_pairs_per_tick\": " << (double)collision_pairs / std::max(options.ticks, 1)
+              << ", \"gpu_buffer_bytes\": " << Stats::get(Stats::GPU_BUFFER_BYTES) << ",\n";
+    std::cout << "  \"stages\": {\n";
+    size_t written = 0;
+    for (const auto& [name, timing] : stages) {
+        std::cout << "    \"" << name << "\": {\"total_ms\": " << timing.total_ms << ", \"avg_ms\": "
+                  << timing.total_ms / std::max(timing.runs, 1) << ", \"max_ms\": " << timing.max_ms
+                  << ", \"runs\": " << timing.runs << "}" << (++written < stages.size() ? "," : "") << "\n";
+    }
+    std::cout << "  }\n}" << std::endl;
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "animation_system.h"
+#include "profiler.h"
+
+namespace {
+
+// Below this many followers per thread, starting threads costs more than it saves
+const size_t MIN_FOLLOWERS_PER_THREAD = 1024;
+
+}
+
+uint32_t AnimationSystem::add_path(std::shared_ptr<Animation> path) {
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (paths[i] == path) return static_cast<uint32_t>(i);
+    }
+    paths.push_back(path);
+    return static_cast<uint32_t>(paths.size() - 1);
+}
+
+size_t AnimationSystem::add_follower(uint32_t path, float time, float speed, float lane_offset,
+                                     std::shared_ptr<Obj3D> object) {
+    path_ids.push_back(path);
+    times.push_back(time);
+    speeds.push_back(speed);
+    lane_offsets.push_back(lane_offset);
+    cursors.push_back(0);
+    transforms.push_back(object ? object->transform : glm::mat4(1.0f));
+    objects.push_back(object);
+    return path_ids.size() - 1;
+}
+
+void AnimationSystem::clear() {
+    path_ids.clear();
+    times.clear();
+    speeds.clear();
+    lane_offsets.clear();
+    cursors.clear();
+    transforms.clear();
+    objects.clear();
+}
+
+void AnimationSystem::update_range(float deltaTime, size_t first, size_t last) {
+    PROFILE_SCOPE("animation_range");
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+    for (size_t i = first; i < last; i++) {
+        const Animation& path = *paths[path_ids[i]];
+        if (path.keyframes.empty()) continue;
+
+        // Keep looping times inside one lap so float precision does not degrade over long sessions
+        float time = times[i] + deltaTime * speeds[i];
+        if (path.looping && path.duration > 0.0f) {
+            time = std::fmod(time, path.duration);
+        }
+        times[i] = time;
+
+        AnimationSample sample = path.sample(time, &cursors[i]);
+        glm::vec3 position = sample.position;
+        if (lane_offsets[i] != 0.0f) {
+            glm::vec3 side = glm::cross(sample.tangent, up);
+            float length = glm::length(side);
+            if (length > 1e-6f) {
+                position += side * (lane_offsets[i] / length);
+            }
+        }
+
+        // translate * rotate(heading, +y), written directly
+        float c = std::cos(sample.heading);
+        float s = std::sin(sample.heading);
+        glm::mat4& m = transforms[i];
+        m[0] = glm::vec4(c, 0.0f, -s, 0.0f);
+        m[1] = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+        m[2] = glm::vec4(s, 0.0f, c, 0.0f);
+        m[3] = glm::vec4(position, 1.0f);
+    }
+}
+
+void AnimationSystem::update(float deltaTime, unsigned threads) {
+    size_t count = size();
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, count / MIN_FOLLOWERS_PER_THREAD)));
+
+    if (threads <= 1) {
+        update_range(deltaTime, 0, count);
+        return;
+    }
+
+    // Followers only write their own entries, so contiguous ranges need no synchronisation
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    size_t per_thread = (count + threads - 1) / threads;
+    for (unsigned t = 1; t < threads; t++) {
+        size_t first = t * per_thread;
+        size_t last = std::min(count, first + per_thread);
+        if (first >= last) break;
+        workers.emplace_back(&AnimationSystem::update_range, this, deltaTime, first, last);
+    }
+    update_range(deltaTime, 0, std::min(count, per_thread));
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void AnimationSystem::apply_transforms() {
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (objects[i]) {
+            objects[i]->set_transform(transforms[i]);
+        }
+    }
+}
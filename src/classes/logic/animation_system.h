@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "../rendering/3D/animation.h"
+#include "../rendering/3D/obj3d.h"
+
+// Moves any number of path followers (cars) along shared animation paths.
+// Followers are stored as parallel arrays and updated in one pass, optionally
+// split across threads, before rendering; results land in `transforms` and are
+// copied to the bound objects by apply_transforms().
+class AnimationSystem {
+public:
+    std::vector<std::shared_ptr<Animation>> paths;
+
+    // One entry per follower
+    std::vector<uint32_t> path_ids;
+    std::vector<float> times;
+    std::vector<float> speeds;          // playback rate, 1 = the path's duration per lap
+    std::vector<float> lane_offsets;    // sideways distance from the path, positive to the right
+    std::vector<size_t> cursors;        // Animation::sample lookup hints
+    std::vector<glm::mat4> transforms;
+    std::vector<std::shared_ptr<Obj3D>> objects;   // may be null for followers without an object
+
+    uint32_t add_path(std::shared_ptr<Animation> path);
+    size_t add_follower(uint32_t path, float time = 0.0f, float speed = 1.0f, float lane_offset = 0.0f,
+                        std::shared_ptr<Obj3D> object = nullptr);
+    size_t size() const { return path_ids.size(); }
+    void clear();
+
+    // threads == 0 uses the hardware concurrency; small batches always run on the calling thread
+    void update(float deltaTime, unsigned threads = 1);
+    void apply_transforms();
+
+private:
+    void update_range(float deltaTime, size_t first, size_t last);
+};
@@ -27,4 +27,23 @@ bool BoundingBox::intersects_ray(const glm::vec3& rayOrigin, const glm::vec3& ra
     
     t = t_min;
     return true;
+}
+
+BoundingBox BoundingBox::transformed(const glm::mat4& transform) const {
+    // Arvo: project the box extents onto each axis of the transform
+    glm::vec3 c = (min + max) * 0.5f;
+    glm::vec3 e = (max - min) * 0.5f;
+    glm::vec3 world_center = glm::vec3(transform * glm::vec4(c, 1.0f));
+    glm::vec3 world_extent(
+        std::abs(transform[0][0]) * e.x + std::abs(transform[1][0]) * e.y + std::abs(transform[2][0]) * e.z,
+        std::abs(transform[0][1]) * e.x + std::abs(transform[1][1]) * e.y + std::abs(transform[2][1]) * e.z,
+        std::abs(transform[0][2]) * e.x + std::abs(transform[1][2]) * e.y + std::abs(transform[2][2]) * e.z);
+
+    BoundingBox result;
+    result.min = world_center - world_extent;
+    result.max = world_center + world_extent;
+    result.center = world_center;
+    result.size = world_extent * 2.0f;
+    result.halfSize = world_extent;
+    return result;
 }
\ No newline at end of file
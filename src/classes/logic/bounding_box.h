@@ -27,4 +27,5 @@ public:
     bool intersects(const std::shared_ptr<BoundingBox>& other) const;
     bool contains(const glm::vec3& point) const;
     bool intersects_ray(const glm::vec3& rayOrigin, const glm::vec3& rayDir, float& t) const;
+    BoundingBox transformed(const glm::mat4& transform) const;
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include <charconv>
+#include <fstream>
+#include <iostream>
+
+#include "buffered_writer.h"
+
+BufferedWriter& BufferedWriter::operator<<(const char* text) {
+    buffer.append(text);
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(const std::string& text) {
+    buffer.append(text);
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(char c) {
+    buffer.push_back(c);
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(float value) {
+    // to_chars without a precision gives the shortest text that reads back to the same float
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    buffer.append(text, result.ptr);
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(double value) {
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    buffer.append(text, result.ptr);
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(int value) {
+    char text[16];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    buffer.append(text, result.ptr);
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(size_t value) {
+    char text[24];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    buffer.append(text, result.ptr);
+    return *this;
+}
+
+bool BufferedWriter::write_to_file(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return false;
+    }
+    file.write(buffer.data(), buffer.size());
+    return file.good();
+}
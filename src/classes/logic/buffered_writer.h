@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+
+class BufferedWriter {
+public:
+    std::string buffer;
+
+    void reserve(size_t bytes) { buffer.reserve(bytes); }
+    size_t size() const { return buffer.size(); }
+    void clear() { buffer.clear(); }
+
+    BufferedWriter& operator<<(const char* text);
+    BufferedWriter& operator<<(const std::string& text);
+    BufferedWriter& operator<<(char c);
+    BufferedWriter& operator<<(float value);
+    BufferedWriter& operator<<(double value);
+    BufferedWriter& operator<<(int value);
+    BufferedWriter& operator<<(size_t value);
+
+    bool write_to_file(const std::string& filename) const;
+};
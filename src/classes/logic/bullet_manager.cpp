@@ -1,25 +1,36 @@
 #include "bullet_manager.h"
+#include "stats.h"
 
-void BulletManager::addBullet(const glm::vec3& position, const glm::vec3& direction) {
+SlotHandle BulletManager::addBullet(const glm::vec3& position, const glm::vec3& direction) {
     bullets.push_back(std::make_shared<Bullet>(position, direction));
+    return handles.insert();
 }
 
 void BulletManager::update(float deltaTime) {
     for (auto& bullet : bullets) {
             bullet->update(deltaTime);
         }
-        
-    bullets.erase(std::remove_if(bullets.begin(), bullets.end(),
-        [](const std::shared_ptr<Bullet>& b) { return !b->active; }),
-    bullets.end());
+
+    for (size_t i = 0; i < bullets.size();) {
+        if (bullets[i]->active) {
+            i++;
+            continue;
+        }
+        uint32_t index = handles.erase(handles.handle_at((uint32_t)i));
+        bullets[index] = std::move(bullets.back());
+        bullets.pop_back();
+    }
+    Stats::set(Stats::LIVE_BULLETS, (int64_t)bullets.size());
 }
 
 void BulletManager::checkCollisions(std::vector<std::shared_ptr<Obj3D>>& objects) {
+    int64_t pairs = 0;
     for (auto& bullet : bullets) {
         if (!bullet->active) continue;
         
         for (auto& obj : objects) {
             if (!obj->collidable) continue;
+            pairs++;
             
             std::shared_ptr<BoundingBox> bulletBBox = bullet->get_world_bbox();
             
@@ -40,6 +51,45 @@ void BulletManager::checkCollisions(std::vector<std::shared_ptr<Obj3D>>& objects
             }
         }
     }
+    Stats::add(Stats::COLLISION_PAIRS, pairs);
+}
+
+void BulletManager::checkCollisions(Scene& scene) {
+    int64_t pairs = 0;
+    for (auto& bullet : bullets) {
+        if (!bullet->active) continue;
+
+        glm::vec3 bullet_min = bullet->position - bullet->bbox->halfSize;
+        glm::vec3 bullet_max = bullet->position + bullet->bbox->halfSize;
+        for (size_t i = 0; i < scene.flags.size(); i++) {
+            if (!(scene.flags[i] & Scene::COLLIDABLE)) continue;
+            pairs++;
+
+            const Scene::Aabb& box = scene.world_bounds[i];
+            bool overlap = (bullet_min.x <= box.max.x && bullet_max.x >= box.min.x) &&
+                           (bullet_min.y <= box.max.y && bullet_max.y >= box.min.y) &&
+                           (bullet_min.z <= box.max.z && bullet_max.z >= box.min.z);
+            if (!overlap) continue;
+
+            if (scene.flags[i] & Scene::ELIMINABLE) {
+                scene.eliminate((uint32_t)i);
+                bullet->active = false;
+            } else {
+                BoundingBox bullet_box, obj_box;
+                bullet_box.min = bullet_min;
+                bullet_box.max = bullet_max;
+                bullet_box.center = bullet->position;
+                obj_box.min = box.min;
+                obj_box.max = box.max;
+                obj_box.center = (box.min + box.max) * 0.5f;
+                bullet->reflect(calculateCollisionNormal(bullet_box, obj_box));
+                // reflect() nudges the bullet out of the box
+                bullet_min = bullet->position - bullet->bbox->halfSize;
+                bullet_max = bullet->position + bullet->bbox->halfSize;
+            }
+        }
+    }
+    Stats::add(Stats::COLLISION_PAIRS, pairs);
 }
 
 std::shared_ptr<BoundingBox> BulletManager::transformBoundingBox(const std::shared_ptr<BoundingBox>& bbox, const glm::mat4& transform) {
@@ -80,19 +130,23 @@ bool BulletManager::checkAABBCollision(const std::shared_ptr<BoundingBox>& a, co
 }
 
 glm::vec3 BulletManager::calculateCollisionNormal(const std::shared_ptr<BoundingBox>& bulletBox, const std::shared_ptr<BoundingBox>& objBox) const {
+    return calculateCollisionNormal(*bulletBox, *objBox);
+}
+
+glm::vec3 BulletManager::calculateCollisionNormal(const BoundingBox& bulletBox, const BoundingBox& objBox) const {
     glm::vec3 penetration;
     const float epsilon = 0.001f;
     
-    penetration.x = std::min(bulletBox->max.x - objBox->min.x, objBox->max.x - bulletBox->min.x) + epsilon;
-    penetration.y = std::min(bulletBox->max.y - objBox->min.y, objBox->max.y - bulletBox->min.y) + epsilon;
-    penetration.z = std::min(bulletBox->max.z - objBox->min.z, objBox->max.z - bulletBox->min.z) + epsilon;
+    penetration.x = std::min(bulletBox.max.x - objBox.min.x, objBox.max.x - bulletBox.min.x) + epsilon;
+    penetration.y = std::min(bulletBox.max.y - objBox.min.y, objBox.max.y - bulletBox.min.y) + epsilon;
+    penetration.z = std::min(bulletBox.max.z - objBox.min.z, objBox.max.z - bulletBox.min.z) + epsilon;
     
     if (penetration.x <= penetration.y && penetration.x <= penetration.z) {
-        return glm::vec3(glm::sign(bulletBox->center.x - objBox->center.x), 0.0f, 0.0f);
+        return glm::vec3(glm::sign(bulletBox.center.x - objBox.center.x), 0.0f, 0.0f);
     } else if (penetration.y <= penetration.x && penetration.y <= penetration.z) {
-        return glm::vec3(0.0f, glm::sign(bulletBox->center.y - objBox->center.y), 0.0f);
+        return glm::vec3(0.0f, glm::sign(bulletBox.center.y - objBox.center.y), 0.0f);
     } else {
-        return glm::vec3(0.0f, 0.0f, glm::sign(bulletBox->center.z - objBox->center.z));
+        return glm::vec3(0.0f, 0.0f, glm::sign(bulletBox.center.z - objBox.center.z));
     }
 }
 
@@ -165,6 +219,7 @@ void BulletManager::render(GLuint shaderProgram) {
     if (!buffersInitialized) return;
         
     glBindVertexArray(cubeVAO);
+    Stats::add(Stats::STATE_CHANGES);
     
     glUniform1i(glGetUniformLocation(shaderProgram, "useTexture"), 0);
 
@@ -184,6 +239,8 @@ void BulletManager::render(GLuint shaderProgram) {
             }
 
             glDrawArrays(GL_TRIANGLES, 0, 36);
+            Stats::add(Stats::DRAW_CALLS);
+            Stats::add(Stats::TRIANGLES, 12);
         }
     }
     
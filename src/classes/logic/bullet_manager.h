@@ -2,10 +2,13 @@
 
 #include "bullet.h"
 #include "../rendering/3D/obj3d.h"
+#include "../rendering/3D/scene.h"
+#include "slot_map.h"
 
 class BulletManager {
 public:
-    std::vector<std::shared_ptr<Bullet>> bullets;
+    std::vector<std::shared_ptr<Bullet>> bullets;   // dense; expired bullets are swapped out
+    SlotMap handles;
     GLuint cubeVAO, cubeVBO;
     bool buffersInitialized;
 
@@ -14,12 +17,20 @@ public:
     void init() {
         setup_cube_buffers();
     }
-    void addBullet(const glm::vec3& position, const glm::vec3& direction);
+    SlotHandle addBullet(const glm::vec3& position, const glm::vec3& direction);
+    // Null once the bullet has expired or hit something
+    Bullet* get(SlotHandle handle) const {
+        uint32_t index = handles.index_of(handle);
+        return index == SlotMap::INVALID_INDEX ? nullptr : bullets[index].get();
+    }
     void update(float deltaTime);
     void checkCollisions(std::vector<std::shared_ptr<Obj3D>>& objects);
+    // Same rules against the scene's world_bounds; call after Scene::update_bounds()
+    void checkCollisions(Scene& scene);
     std::shared_ptr<BoundingBox> transformBoundingBox(const std::shared_ptr<BoundingBox>& bbox, const glm::mat4& transform);
     bool checkAABBCollision(const std::shared_ptr<BoundingBox>& a, const std::shared_ptr<BoundingBox>& b) const;
     glm::vec3 calculateCollisionNormal(const std::shared_ptr<BoundingBox>& bulletBox, const std::shared_ptr<BoundingBox>& objBox) const;
+    glm::vec3 calculateCollisionNormal(const BoundingBox& bulletBox, const BoundingBox& objBox) const;
     void setup_cube_buffers();
     void render(GLuint shaderProgram);
     void cleanup() {
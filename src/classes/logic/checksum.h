@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 32-bit FNV-1a. hash can be chained across calls to cover several buffers.
+inline uint32_t fnv1a(const void* data, size_t bytes, uint32_t hash = 2166136261u) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < bytes; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,70 @@
+#include "frustum.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void Frustum::extract(const glm::mat4& m) {
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0;    // left
+    planes[1] = row3 - row0;    // right
+    planes[2] = row3 + row1;    // bottom
+    planes[3] = row3 - row1;    // top
+    planes[4] = row3 + row2;    // near
+    planes[5] = row3 - row2;    // far
+
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 plane = i < 6 ? planes[i] : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        plane_x[i] = plane.x;
+        plane_y[i] = plane.y;
+        plane_z[i] = plane.z;
+        plane_w[i] = plane.w;
+    }
+}
+
+bool Frustum::intersects(const glm::vec3& min, const glm::vec3& max) const {
+#if defined(__SSE2__)
+    // Centre/extent form: the box is outside a plane when n.c + d + |n|.e < 0.
+    // Four planes per pass, so the six planes take two passes and no branches.
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 cx = _mm_set1_ps((min.x + max.x) * 0.5f);
+    const __m128 cy = _mm_set1_ps((min.y + max.y) * 0.5f);
+    const __m128 cz = _mm_set1_ps((min.z + max.z) * 0.5f);
+    const __m128 ex = _mm_set1_ps((max.x - min.x) * 0.5f);
+    const __m128 ey = _mm_set1_ps((max.y - min.y) * 0.5f);
+    const __m128 ez = _mm_set1_ps((max.z - min.z) * 0.5f);
+
+    int outside = 0;
+    for (int i = 0; i < 8; i += 4) {
+        __m128 nx = _mm_load_ps(plane_x + i);
+        __m128 ny = _mm_load_ps(plane_y + i);
+        __m128 nz = _mm_load_ps(plane_z + i);
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+                                     _mm_add_ps(_mm_mul_ps(nz, cz), _mm_load_ps(plane_w + i)));
+        __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(nx, abs_mask), ex),
+                                              _mm_mul_ps(_mm_and_ps(ny, abs_mask), ey)),
+                                   _mm_mul_ps(_mm_and_ps(nz, abs_mask), ez));
+        outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+    }
+    return outside == 0;
+#else
+    for (const auto& plane : planes) {
+        // Corner of the box furthest along the plane normal
+        glm::vec3 p(plane.x >= 0.0f ? max.x : min.x,
+                    plane.y >= 0.0f ? max.y : min.y,
+                    plane.z >= 0.0f ? max.z : min.z);
+        if (plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "bounding_box.h"
+
+// View frustum planes (ax + by + cz + d >= 0 inside), extracted from a
+// combined projection * view matrix.
+class Frustum {
+public:
+    glm::vec4 planes[6];
+
+    // Planes transposed into lanes for the SSE box test; lanes 6-7 always pass
+    alignas(16) float plane_x[8];
+    alignas(16) float plane_y[8];
+    alignas(16) float plane_z[8];
+    alignas(16) float plane_w[8];
+
+    void extract(const glm::mat4& view_projection);
+    bool intersects(const glm::vec3& min, const glm::vec3& max) const;
+    bool intersects(const BoundingBox& box) const { return intersects(box.min, box.max); }
+};
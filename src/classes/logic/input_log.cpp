@@ -0,0 +1,179 @@
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+#include "input_log.h"
+
+bool InputRecorder::start(const std::string& filename, uint32_t seed) {
+    stop();
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Could not open input log " << filename << std::endl;
+        return false;
+    }
+    InputLogHeader header;
+    header.seed = seed;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    frames = events = 0;
+    std::cout << "Recording input to " << filename << " (seed " << seed << ")" << std::endl;
+    return true;
+}
+
+void InputRecorder::stop() {
+    if (!file.is_open()) return;
+    std::cout << "Recorded " << frames << " frames, " << events << " input events ("
+              << (size_t)file.tellp() << " bytes)" << std::endl;
+    file.close();
+}
+
+void InputRecorder::frame(float dt) {
+    if (!file.is_open()) return;
+    file.put(InputEvent::FRAME);
+    put_float(dt);
+    frames++;
+}
+
+void InputRecorder::key(int key, int action, int mods) {
+    if (!file.is_open()) return;
+    file.put(InputEvent::KEY);
+    put_varint(key);
+    file.put((char)action);
+    file.put((char)mods);
+    events++;
+}
+
+void InputRecorder::mouse_button(int button, int action, int mods, double x, double y) {
+    if (!file.is_open()) return;
+    file.put(InputEvent::MOUSE_BUTTON);
+    file.put((char)button);
+    file.put((char)action);
+    file.put((char)mods);
+    put_float((float)x);
+    put_float((float)y);
+    events++;
+}
+
+void InputRecorder::cursor(double x, double y) {
+    if (!file.is_open()) return;
+    file.put(InputEvent::CURSOR);
+    put_float((float)x);
+    put_float((float)y);
+    events++;
+}
+
+void InputRecorder::put_varint(int value) {
+    // Zigzag so GLFW_KEY_UNKNOWN (-1) stays one byte
+    uint32_t bits = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    while (bits >= 0x80) {
+        file.put((char)(bits | 0x80));
+        bits >>= 7;
+    }
+    file.put((char)bits);
+}
+
+void InputRecorder::put_float(float value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool InputPlayer::open(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Could not open input log " << filename << std::endl;
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    InputLogHeader header, expected;
+    if (data.size() < sizeof(header)) {
+        std::cerr << "Input log " << filename << " is truncated" << std::endl;
+        data.clear();
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version) {
+        std::cerr << "Input log " << filename << " has an unknown format" << std::endl;
+        data.clear();
+        return false;
+    }
+    seed = header.seed;
+    position = sizeof(header);
+    frames = 0;
+    std::cout << "Replaying input from " << filename << " (seed " << seed << ")" << std::endl;
+    return true;
+}
+
+bool InputPlayer::next_frame(float& dt) {
+    // Skip whatever the previous frame did not consume
+    InputEvent event;
+    while (next_event(event)) {}
+    if (finished() || data[position] != InputEvent::FRAME) return false;
+    position++;
+    if (!get_float(dt)) return false;
+    frames++;
+    return true;
+}
+
+bool InputPlayer::next_event(InputEvent& event) {
+    if (finished() || data[position] == InputEvent::FRAME) return false;
+
+    event = InputEvent();
+    event.type = (InputEvent::Type)data[position++];
+    bool ok = true;
+    switch (event.type) {
+    case InputEvent::KEY:
+        ok = get_varint(event.code) && position + 2 <= data.size();
+        if (ok) {
+            event.action = data[position++];
+            event.mods = data[position++];
+        }
+        break;
+    case InputEvent::MOUSE_BUTTON: {
+        float x = 0.0f, y = 0.0f;
+        ok = position + 3 <= data.size();
+        if (ok) {
+            event.code = data[position++];
+            event.action = data[position++];
+            event.mods = data[position++];
+            ok = get_float(x) && get_float(y);
+        }
+        event.x = x;
+        event.y = y;
+        break;
+    }
+    case InputEvent::CURSOR: {
+        float x = 0.0f, y = 0.0f;
+        ok = get_float(x) && get_float(y);
+        event.x = x;
+        event.y = y;
+        break;
+    }
+    default:
+        ok = false;
+        break;
+    }
+    if (!ok) {
+        std::cerr << "Input log is corrupt at byte " << position << ", stopping replay" << std::endl;
+        position = data.size();
+    }
+    return ok;
+}
+
+bool InputPlayer::get_varint(int& value) {
+    uint32_t bits = 0;
+    for (int shift = 0; shift < 35 && position < data.size(); shift += 7) {
+        uint8_t byte = data[position++];
+        bits |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            value = (int)(bits >> 1) ^ -(int)(bits & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InputPlayer::get_float(float& value) {
+    if (position + sizeof(value) > data.size()) return false;
+    std::memcpy(&value, &data[position], sizeof(value));
+    position += sizeof(value);
+    return true;
+}
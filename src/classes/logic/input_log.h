@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+
+// Input session log (.rtin) for reproducible runs. The recorder captures what
+// the GLFW callbacks deliver plus the dt of every frame; the player hands
+// them back in the same order, so a replayed session steps the editor through
+// exactly the same states regardless of how long each frame takes to draw.
+//
+// Layout: InputLogHeader, then a stream of records, each starting with a tag
+// byte. FRAME carries the frame's dt and is followed by the events polled at
+// the end of that frame. Key codes are zigzag varints, positions are floats.
+
+struct InputLogHeader {
+    char magic[4] = {'R', 'T', 'I', 'N'};
+    uint32_t version = 1;
+    uint32_t seed = 0;
+    uint32_t reserved = 0;
+};
+
+struct InputEvent {
+    enum Type : uint8_t { FRAME, KEY, MOUSE_BUTTON, CURSOR };
+
+    Type type = FRAME;
+    int code = 0;       // key or mouse button
+    int action = 0;
+    int mods = 0;
+    double x = 0.0;     // cursor position
+    double y = 0.0;
+    float dt = 0.0f;    // FRAME only
+};
+
+class InputRecorder {
+public:
+    size_t frames = 0;
+    size_t events = 0;
+
+    bool start(const std::string& filename, uint32_t seed);
+    void stop();
+    bool recording() const { return file.is_open(); }
+
+    void frame(float dt);
+    void key(int key, int action, int mods);
+    void mouse_button(int button, int action, int mods, double x, double y);
+    void cursor(double x, double y);
+
+private:
+    std::ofstream file;
+
+    void put_varint(int value);
+    void put_float(float value);
+};
+
+class InputPlayer {
+public:
+    uint32_t seed = 0;
+    size_t frames = 0;
+
+    bool open(const std::string& filename);
+    bool active() const { return !data.empty(); }
+    bool finished() const { return position >= data.size(); }
+
+    // Advances to the next frame marker; false once the log is exhausted
+    bool next_frame(float& dt);
+    // Events recorded after the current frame marker, in order; false at the next marker
+    bool next_event(InputEvent& event);
+
+private:
+    std::vector<uint8_t> data;
+    size_t position = 0;
+
+    bool get_varint(int& value);
+    bool get_float(float& value);
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. The mapping is released when the
+// object goes out of scope.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+
+    const char* data() const { return static_cast<const char*>(address); }
+    size_t size() const { return length; }
+    bool is_open() const { return address != nullptr; }
+
+private:
+    void* address = nullptr;
+    size_t length = 0;
+};
@@ -11,6 +11,7 @@
 #include <unordered_map>
 
 #include "obj3dwriter.h"
+#include "stats.h"
 
 std::string Obj3DWriter::find_texture_file(const std::string& directory, const std::string& baseName) {
     std::vector<std::string> extensions = {".png", ".jpg", ".jpeg", ".bmp", ".tga", ".tiff"};
@@ -30,12 +31,33 @@ std::string Obj3DWriter::find_texture_file(const std::string& directory, const s
     return baseName;
 }
 
+std::unordered_map<std::string, std::shared_ptr<Mesh>> Obj3DWriter::mesh_registry;
+
+std::string Obj3DWriter::registry_key(const std::string& filename) {
+    return std::filesystem::path(filename).lexically_normal().generic_string();
+}
+
 void Obj3DWriter::write(std::shared_ptr<Obj3D> obj){
+    std::string key = registry_key(obj->obj_file);
+    auto cached = mesh_registry.find(key);
+    if (cached != mesh_registry.end()) {
+        obj->mesh = cached->second;
+        obj->buffers_created = true;
+        return;
+    }
+
+    Stats::note_event("load " + key);
     std::shared_ptr<Mesh> mesh = load_from_file(obj->obj_file);
     obj->mesh = mesh;
+    if (!mesh) return;
     obj->setup_buffers();
+    mesh_registry[key] = mesh;
 };
 
+void Obj3DWriter::forget(const std::string& filename){
+    mesh_registry.erase(registry_key(filename));
+}
+
 std::shared_ptr<Mesh> Obj3DWriter::load_from_file(const std::string& filename){
     std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
     std::ifstream file(filename);
@@ -138,40 +160,6 @@ std::shared_ptr<Mesh> Obj3DWriter::load_from_file(const std::string& filename){
     return mesh;
 }
 
-std::vector<std::shared_ptr<Obj3D>> Obj3DWriter::file_reader() {
-    std::string path = "../objs/config.cfg";
-    std::vector<std::shared_ptr<Obj3D>> objs;
-    
-    std::ifstream arq(path);
-    if (!arq.is_open()) {
-        std::cerr << "Warning: Could not open config file: " << path << std::endl;
-        return objs;
-    }
-
-    std::string line;
-    while (std::getline(arq, line)) {
-        if (line.empty() || line[0] == '#') continue;
-        
-        std::istringstream iss(line);
-        std::string mesh_nm;
-        std::string mesh_file;
-        int selectable;
-        int collidable;
-        int eliminable;
-        
-        if (iss >> mesh_nm >> mesh_file >> selectable >> collidable >> eliminable) {
-            auto obj3d = std::make_shared<Obj3D>();
-            obj3d->name = mesh_nm;
-            obj3d->obj_file = mesh_file;
-            obj3d->selectable = selectable;
-            obj3d->collidable = collidable;
-            obj3d->eliminable = eliminable;
-            objs.push_back(obj3d);
-        }
-    }
-    return objs;
-}
-
 std::unordered_map<std::string, std::shared_ptr<Material>> Obj3DWriter::load_materials(const std::string& mtlFilePath) {
     std::unordered_map<std::string, std::shared_ptr<Material>> materials;
     std::ifstream file(mtlFilePath);
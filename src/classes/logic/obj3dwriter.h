@@ -2,14 +2,21 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 #include "../rendering/3D/obj3d.h"
 
 class Obj3DWriter{
 public:
+    // Meshes already loaded and uploaded, keyed by normalized OBJ path; objects
+    // that reference the same file share one Mesh and its VAOs
+    static std::unordered_map<std::string, std::shared_ptr<Mesh>> mesh_registry;
+
+    static std::string registry_key(const std::string& filename);
     static void write(std::shared_ptr<Obj3D> obj);
+    // Drops a cached mesh so the next write() reloads it, e.g. after re-exporting the track
+    static void forget(const std::string& filename);
     static std::shared_ptr<Mesh> load_from_file(const std::string& filename);
-    static std::vector<std::shared_ptr<Obj3D>> file_reader();
     static std::unordered_map<std::string, std::shared_ptr<Material>> load_materials(const std::string& mtlFilePath);
     static std::string find_texture_file(const std::string& directory, const std::string& baseName);
 };
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cmath>
+
+#include "point_grid.h"
+
+glm::ivec2 PointGrid::cell_of(const glm::vec2& point) const {
+    return glm::ivec2(static_cast<int>(std::floor(point.x / cell_size)),
+                      static_cast<int>(std::floor(point.y / cell_size)));
+}
+
+uint64_t PointGrid::key(const glm::ivec2& cell) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) << 32) | static_cast<uint32_t>(cell.y);
+}
+
+void PointGrid::clear() {
+    layers.clear();
+    level_keys.clear();
+    index_slots.clear();
+    slot_indices.clear();
+    free_slots.clear();
+}
+
+void PointGrid::file(uint32_t slot, const glm::vec2& point, float level) {
+    auto layer = layers.find(level);
+    if (layer == layers.end()) {
+        layer = layers.emplace(level, Cells()).first;
+        level_keys.insert(std::lower_bound(level_keys.begin(), level_keys.end(), level), level);
+    }
+    layer->second[key(cell_of(point))].push_back(slot);
+}
+
+void PointGrid::unfile(uint32_t slot, const glm::vec2& point, float level) {
+    auto layer = layers.find(level);
+    if (layer == layers.end()) return;
+    Cells& cells = layer->second;
+    auto found = cells.find(key(cell_of(point)));
+    if (found == cells.end()) return;
+
+    auto& bucket = found->second;
+    auto it = std::find(bucket.begin(), bucket.end(), slot);
+    if (it != bucket.end()) {
+        *it = bucket.back();
+        bucket.pop_back();
+    }
+    if (bucket.empty()) {
+        cells.erase(found);
+    }
+    if (cells.empty()) {
+        layers.erase(layer);
+        level_keys.erase(std::lower_bound(level_keys.begin(), level_keys.end(), level));
+    }
+}
+
+void PointGrid::insert(uint32_t index, const glm::vec2& point, float level) {
+    if (index > index_slots.size()) return;
+    uint32_t slot;
+    if (free_slots.empty()) {
+        slot = static_cast<uint32_t>(slot_indices.size());
+        slot_indices.push_back(index);
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    index_slots.insert(index_slots.begin() + index, slot);
+    for (size_t i = index; i < index_slots.size(); i++) {
+        slot_indices[index_slots[i]] = static_cast<uint32_t>(i);
+    }
+    file(slot, point, level);
+}
+
+void PointGrid::remove(uint32_t index, const glm::vec2& point, float level) {
+    if (index >= index_slots.size()) return;
+    uint32_t slot = index_slots[index];
+    unfile(slot, point, level);
+    free_slots.push_back(slot);
+    index_slots.erase(index_slots.begin() + index);
+    for (size_t i = index; i < index_slots.size(); i++) {
+        slot_indices[index_slots[i]] = static_cast<uint32_t>(i);
+    }
+}
+
+void PointGrid::move(uint32_t index, const glm::vec2& from, const glm::vec2& to, float level) {
+    if (index >= index_slots.size() || cell_of(from) == cell_of(to)) return;
+    unfile(index_slots[index], from, level);
+    file(index_slots[index], to, level);
+}
+
+void PointGrid::change_level(uint32_t index, const glm::vec2& point, float from, float to) {
+    if (index >= index_slots.size() || from == to) return;
+    unfile(index_slots[index], point, from);
+    file(index_slots[index], point, to);
+}
+
+int PointGrid::nearest(const glm::vec2& query, float radius, const std::vector<glm::vec2>& points,
+                       float level) const {
+    auto layer = layers.find(level);
+    if (layer == layers.end()) return -1;
+    const Cells& cells = layer->second;
+
+    glm::ivec2 lo = cell_of(query - glm::vec2(radius));
+    glm::ivec2 hi = cell_of(query + glm::vec2(radius));
+
+    int best = -1;
+    float best_distance = radius * radius;
+    for (int x = lo.x; x <= hi.x; x++) {
+        for (int y = lo.y; y <= hi.y; y++) {
+            auto found = cells.find(key(glm::ivec2(x, y)));
+            if (found == cells.end()) continue;
+
+            for (uint32_t slot : found->second) {
+                uint32_t index = slot_indices[slot];
+                glm::vec2 d = points[index] - query;
+                float distance = glm::dot(d, d);
+                if (distance <= best_distance) {
+                    best_distance = distance;
+                    best = static_cast<int>(index);
+                }
+            }
+        }
+    }
+    return best;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Uniform hash grid over 2D points, addressed by their index in an external
+// array. Only occupied cells are stored, so the grid is unbounded and sparse.
+// Points are filed under a level (e.g. their elevation) and every level keeps
+// its own cells, so a lookup on one level never visits the points of another.
+class PointGrid {
+public:
+    float cell_size;
+
+    PointGrid(float cell = 1.0f) : cell_size(cell) {}
+
+    void clear();
+    // The external array gained a point at index (or lost the one there); the indices
+    // after it move along, which only touches the flat slot tables, not the cells
+    void insert(uint32_t index, const glm::vec2& point, float level = 0.0f);
+    void remove(uint32_t index, const glm::vec2& point, float level = 0.0f);
+    void move(uint32_t index, const glm::vec2& from, const glm::vec2& to, float level = 0.0f);
+    void change_level(uint32_t index, const glm::vec2& point, float from, float to);
+
+    // Closest point on the level within radius of query, or -1. points is the array the
+    // indices refer to.
+    int nearest(const glm::vec2& query, float radius, const std::vector<glm::vec2>& points,
+                float level = 0.0f) const;
+
+    // Levels holding at least one point, ascending
+    const std::vector<float>& levels() const { return level_keys; }
+
+private:
+    // Cells hold slots, which stay put while the indices around them shift
+    using Cells = std::unordered_map<uint64_t, std::vector<uint32_t>>;
+
+    std::map<float, Cells> layers;
+    std::vector<float> level_keys;
+    std::vector<uint32_t> index_slots;  // external index -> slot
+    std::vector<uint32_t> slot_indices; // slot -> external index
+    std::vector<uint32_t> free_slots;
+
+    glm::ivec2 cell_of(const glm::vec2& point) const;
+    static uint64_t key(const glm::ivec2& cell);
+    void file(uint32_t slot, const glm::vec2& point, float level);
+    void unfile(uint32_t slot, const glm::vec2& point, float level);
+};
@@ -0,0 +1,152 @@
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+#include "profiler.h"
+#include "buffered_writer.h"
+
+std::vector<Profiler::TraceEvent> Profiler::trace;
+size_t Profiler::trace_next = 0;
+std::unordered_map<const char*, Profiler::Window> Profiler::windows;
+size_t Profiler::dropped = 0;
+
+namespace {
+
+std::mutex rings_mutex;
+std::vector<std::unique_ptr<ProfileRing>> rings;     // never shrinks, so pointers stay valid
+
+struct RingHandle {
+    ProfileRing* ring = nullptr;
+    ~RingHandle() {
+        if (ring) ring->in_use.store(false, std::memory_order_release);
+    }
+};
+
+thread_local RingHandle thread_handle;
+
+}
+
+uint64_t Profiler::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ProfileRing& Profiler::thread_ring() {
+    if (thread_handle.ring) return *thread_handle.ring;
+
+    // First event on this thread: reuse the ring of a thread that has exited
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    for (auto& ring : rings) {
+        bool expected = false;
+        if (ring->in_use.compare_exchange_strong(expected, true)) {
+            thread_handle.ring = ring.get();
+            return *ring;
+        }
+    }
+    rings.push_back(std::make_unique<ProfileRing>());
+    rings.back()->track = rings.size() - 1;
+    rings.back()->in_use.store(true);
+    thread_handle.ring = rings.back().get();
+    return *thread_handle.ring;
+}
+
+void Profiler::record(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+    ProfileRing& ring = thread_ring();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    ring.events[head % ProfileRing::CAPACITY] = {name, begin_ns, end_ns};
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::record_gpu(const char* name, uint64_t begin_ns, uint64_t duration_ns) {
+    add_sample(name, begin_ns, begin_ns + duration_ns, GPU_TRACK);
+}
+
+void Profiler::add_sample(const char* name, uint64_t begin_ns, uint64_t end_ns, uint32_t track) {
+    Window& window = windows[name];
+    if (window.samples.size() < WINDOW) {
+        window.samples.push_back(end_ns - begin_ns);
+    } else {
+        window.samples[window.next] = end_ns - begin_ns;
+        window.next = (window.next + 1) % WINDOW;
+    }
+
+    if (trace.size() < MAX_TRACE_EVENTS) {
+        trace.push_back({name, begin_ns, end_ns, track});
+    } else {
+        trace[trace_next] = {name, begin_ns, end_ns, track};
+        trace_next = (trace_next + 1) % MAX_TRACE_EVENTS;
+    }
+}
+
+void Profiler::collect() {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    for (auto& ring : rings) {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        if (head - ring->tail > ProfileRing::CAPACITY) {
+            // The writer lapped us; the oldest entries are gone
+            dropped += head - ring->tail - ProfileRing::CAPACITY;
+            ring->tail = head - ProfileRing::CAPACITY;
+        }
+        for (; ring->tail < head; ring->tail++) {
+            const ProfileEvent& event = ring->events[ring->tail % ProfileRing::CAPACITY];
+            add_sample(event.name, event.begin_ns, event.end_ns, ring->track);
+        }
+    }
+}
+
+void Profiler::print_table(std::ostream& out) {
+    // The same name can be several literals (one per translation unit), so merge by text
+    std::map<std::string, std::vector<uint64_t>> merged;
+    for (const auto& [name, window] : windows) {
+        auto& samples = merged[name];
+        samples.insert(samples.end(), window.samples.begin(), window.samples.end());
+    }
+
+    out << std::left << std::setw(24) << "scope" << std::right << std::setw(10) << "min ms" << std::setw(10) << "avg ms"
+        << std::setw(10) << "p99 ms" << std::setw(8) << "n" << "\n";
+    for (auto& [name, sorted] : merged) {
+        if (sorted.empty()) continue;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (uint64_t sample : sorted) total += sample;
+        size_t p99 = std::min(sorted.size() - 1, (size_t)(sorted.size() * 0.99));
+        out << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << sorted.front() * 1e-6 << std::setw(10) << total / sorted.size() * 1e-6
+            << std::setw(10) << sorted[p99] * 1e-6 << std::setw(8) << sorted.size() << "\n";
+    }
+    if (dropped > 0) {
+        out << dropped << " events lost to full thread rings\n";
+    }
+    out.flush();
+}
+
+bool Profiler::write_chrome_trace(const std::string& filename) {
+    if (trace.empty()) return false;
+    uint64_t origin = trace.front().begin_ns;
+    for (const auto& event : trace) origin = std::min(origin, event.begin_ns);
+
+    BufferedWriter writer;
+    writer.reserve(trace.size() * 96);
+    writer << "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < trace.size(); i++) {
+        const auto& event = trace[i];
+        // Complete events, times in microseconds
+        writer << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (int)event.track
+               << ",\"ts\":" << (event.begin_ns - origin) * 1e-3
+               << ",\"dur\":" << (event.end_ns - event.begin_ns) * 1e-3 << "}"
+               << (i + 1 < trace.size() ? ",\n" : "\n");
+    }
+    writer << "],\"displayTimeUnit\":\"ms\"}\n";
+    return writer.write_to_file(filename);
+}
+
+void Profiler::reset() {
+    trace.clear();
+    trace_next = 0;
+    windows.clear();
+    dropped = 0;
+}
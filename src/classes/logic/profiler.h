@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <ostream>
+
+// Frame profiler. Scopes record (name, begin, end) into a ring buffer owned by
+// the recording thread, so recording takes no lock; the main thread drains
+// every ring once per frame in collect(), which feeds the rolling min/avg/p99
+// table and the event list exported as a Chrome trace (chrome://tracing,
+// ui.perfetto.dev). Names must be string literals or otherwise outlive the
+// profiler. The trace keeps the latest MAX_TRACE_EVENTS events.
+//
+// The PROFILE_* macros compile to nothing unless RACETRACK_PROFILE is defined.
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef RACETRACK_PROFILE
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_COLLECT() Profiler::collect()
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COLLECT() ((void)0)
+#endif
+
+struct ProfileEvent {
+    const char* name;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+};
+
+// Single producer (the owning thread), single consumer (collect)
+struct ProfileRing {
+    static const size_t CAPACITY = 4096;
+
+    ProfileEvent events[CAPACITY];
+    std::atomic<uint64_t> head{0};
+    uint64_t tail = 0;                  // consumer side
+    std::atomic<bool> in_use{false};    // rings of finished threads are handed to new ones
+    uint32_t track = 0;                 // trace row
+};
+
+class Profiler {
+public:
+    static const uint32_t GPU_TRACK = 1000;
+    static const size_t WINDOW = 300;           // samples per name for the table
+    static const size_t MAX_TRACE_EVENTS = 200000;
+
+    static uint64_t now_ns();
+    static void record(const char* name, uint64_t begin_ns, uint64_t end_ns);
+    // GPU passes come from timer queries on the main thread and get their own trace row
+    static void record_gpu(const char* name, uint64_t begin_ns, uint64_t duration_ns);
+
+    static void collect();
+    static void print_table(std::ostream& out);
+    static bool write_chrome_trace(const std::string& filename);
+    static void reset();
+
+    static size_t dropped_events() { return dropped; }
+
+private:
+    struct TraceEvent {
+        const char* name;
+        uint64_t begin_ns;
+        uint64_t end_ns;
+        uint32_t track;
+    };
+
+    // Last WINDOW durations per scope name, keyed by the literal's address
+    struct Window {
+        std::vector<uint64_t> samples;
+        size_t next = 0;
+    };
+
+    static std::vector<TraceEvent> trace;   // circular once full, keeping the latest events
+    static size_t trace_next;
+    static std::unordered_map<const char*, Window> windows;
+    static size_t dropped;
+
+    static ProfileRing& thread_ring();
+    static void add_sample(const char* name, uint64_t begin_ns, uint64_t end_ns, uint32_t track);
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : name(name), begin(Profiler::now_ns()) {}
+    ~ProfileScope() { Profiler::record(name, begin, Profiler::now_ns()); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t begin;
+};
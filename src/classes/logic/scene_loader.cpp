@@ -0,0 +1,183 @@
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "scene_loader.h"
+#include "obj3dwriter.h"
+#include "stats.h"
+#include "../rendering/3D/render_device.h"
+
+SceneLoader::~SceneLoader() {
+    wait();
+}
+
+void SceneLoader::start(const std::vector<std::shared_ptr<Obj3D>>& to_load, unsigned threads) {
+    std::vector<Request> requests;
+    for (const auto& obj : to_load) {
+        requests.push_back({obj});
+    }
+    start(requests, threads);
+}
+
+void SceneLoader::start(const std::vector<Request>& requests, unsigned threads) {
+    wait();
+    objects.clear();
+    jobs.clear();
+    finished.clear();
+    ready_objects = 0;
+    next_job = 0;
+    begin = end = std::chrono::steady_clock::now();
+
+    // One job per distinct file; files already in the registry finish on the first pump
+    // Private requests always get a job of their own
+    std::unordered_map<std::string, size_t> job_of_file;
+    std::vector<std::shared_ptr<Obj3D>> cached;
+    for (const auto& request : requests) {
+        const auto& obj = request.obj;
+        objects.push_back(obj);
+        std::string key = Obj3DWriter::registry_key(obj->obj_file);
+        if (request.shared && Obj3DWriter::mesh_registry.count(key)) {
+            cached.push_back(obj);
+            continue;
+        }
+        auto inserted = request.shared ? job_of_file.emplace(key, jobs.size())
+                                       : std::make_pair(job_of_file.end(), true);
+        if (inserted.second) {
+            jobs.emplace_back();
+            jobs.back().key = key;
+            jobs.back().obj_file = obj->obj_file;
+            jobs.back().priority = request.priority;
+            jobs.back().shared = request.shared;
+            jobs.back().users.push_back(obj);
+            continue;
+        }
+        Job& job = jobs[inserted.first->second];
+        job.priority = std::min(job.priority, request.priority);
+        job.users.push_back(obj);
+    }
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.priority < b.priority; });
+    file_count = jobs.size();
+    if (!cached.empty()) {
+        jobs.emplace_back();
+        jobs.back().users = cached;
+        finished.push_back(jobs.size() - 1);
+    }
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = (unsigned)std::min<size_t>(threads, jobs.size());
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back(&SceneLoader::work, this);
+    }
+}
+
+void SceneLoader::work() {
+    for (size_t index = next_job++; index < jobs.size(); index = next_job++) {
+        Job& job = jobs[index];
+        if (!job.obj_file.empty()) {
+            prepare(job);
+        }
+        std::lock_guard<std::mutex> lock(finished_mutex);
+        if (!job.obj_file.empty()) finished.push_back(index);
+    }
+}
+
+// Everything that does not need the GL context
+void SceneLoader::prepare(Job& job) {
+    job.mesh = Obj3DWriter::load_from_file(job.obj_file);
+    if (!job.mesh) return;
+
+    Obj3D builder;
+    builder.mesh = job.mesh;
+    for (auto& group : job.mesh->groups) {
+        job.vertices.emplace_back();
+        job.full_detail_counts.push_back(builder.build_group_vertices(*group, job.vertices.back()));
+    }
+
+    std::string directory = job.obj_file.substr(0, job.obj_file.find_last_of("/\\"));
+    std::unordered_set<Material*> seen;
+    auto decode = [&](const std::string& map, unsigned int& target) {
+        if (map.empty() || target != 0) return;
+        std::string path = directory + "/" + map;
+        std::replace(path.begin(), path.end(), '\\', '/');
+        TextureImage image;
+        if (!image.load(path)) {
+            std::cerr << "Texture failed to load at path: " << path << std::endl;
+            return;
+        }
+        job.textures.emplace_back(&target, std::move(image));
+    };
+    for (const auto& group : job.mesh->groups) {
+        if (!group->material || !seen.insert(group->material.get()).second) continue;
+        decode(group->material->diffuseMap, group->material->diffuse_texture);
+        decode(group->material->specularMap, group->material->specular_texture);
+    }
+}
+
+void SceneLoader::upload(Job& job) {
+    if (job.mesh) {
+        for (size_t i = 0; i < job.mesh->groups.size(); i++) {
+            const auto& group = job.mesh->groups[i];
+            Obj3D::upload_group_buffers(group, job.vertices[i].data(), job.vertices[i].size() / 8);
+            group->vert_count = job.full_detail_counts[i];
+        }
+        for (auto& [target, image] : job.textures) {
+            *target = RenderDevice::current().create_texture(image);
+        }
+        if (job.shared) {
+            Obj3DWriter::mesh_registry[job.key] = job.mesh;
+        }
+        Stats::note_event("load " + job.key);
+    }
+
+    for (const auto& obj : job.users) {
+        if (job.obj_file.empty()) {
+            obj->mesh = Obj3DWriter::mesh_registry[Obj3DWriter::registry_key(obj->obj_file)];
+        } else {
+            obj->mesh = job.mesh;
+        }
+        obj->buffers_created = obj->mesh != nullptr;
+    }
+
+    // The decoded data is not needed once it is on the device
+    job.vertices.clear();
+    job.vertices.shrink_to_fit();
+    job.textures.clear();
+}
+
+void SceneLoader::pump(double budget_ms, const ReadyCallback& ready) {
+    auto pump_begin = std::chrono::steady_clock::now();
+    while (loading()) {
+        size_t index;
+        {
+            std::lock_guard<std::mutex> lock(finished_mutex);
+            if (finished.empty()) break;
+            index = finished.front();
+            finished.erase(finished.begin());
+        }
+        Job& job = jobs[index];
+        upload(job);
+        for (const auto& obj : job.users) {
+            ready(obj);
+        }
+        ready_objects += job.users.size();
+        end = std::chrono::steady_clock::now();
+
+        if (std::chrono::duration<double, std::milli>(end - pump_begin).count() >= budget_ms) break;
+    }
+    if (!loading()) wait();
+}
+
+void SceneLoader::wait() {
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+double SceneLoader::elapsed_ms() const {
+    auto until = loading() ? std::chrono::steady_clock::now() : end;
+    return std::chrono::duration<double, std::milli>(until - begin).count();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+
+#include "../rendering/3D/obj3d.h"
+#include "../rendering/3D/texture_image.h"
+
+// Loads the OBJ files of a set of objects in the background. Worker threads
+// parse the OBJ and MTL, build the interleaved vertices and decode the
+// textures; pump(), called once per frame on the context thread, uploads the
+// finished files through the RenderDevice and hands every object that uses
+// them to the ready callback. Objects sharing a file are loaded once and
+// share the mesh, as with Obj3DWriter::write.
+class SceneLoader {
+public:
+    using ReadyCallback = std::function<void(const std::shared_ptr<Obj3D>&)>;
+
+    struct Request {
+        std::shared_ptr<Obj3D> obj;
+        int priority = 0;       // files needed by lower values are parsed first
+        bool shared = true;     // false: the mesh is not shared through the registry
+    };
+
+    ~SceneLoader();
+
+    void start(const std::vector<Request>& requests, unsigned threads = 0);
+    void start(const std::vector<std::shared_ptr<Obj3D>>& objects, unsigned threads = 0);
+    // Uploads finished files until budget_ms is spent (at least one per call)
+    void pump(double budget_ms, const ReadyCallback& ready);
+    void wait();
+
+    bool loading() const { return ready_objects < objects.size(); }
+    size_t total() const { return objects.size(); }
+    size_t done() const { return ready_objects; }
+    size_t files() const { return file_count; }
+    double elapsed_ms() const;
+
+private:
+    struct Job {
+        std::string key;                                // Obj3DWriter registry key
+        std::string obj_file;
+        int priority = 0;
+        bool shared = true;
+        std::vector<std::shared_ptr<Obj3D>> users;
+        std::shared_ptr<Mesh> mesh;
+        std::vector<std::vector<float>> vertices;       // per group, full detail then LODs
+        std::vector<int> full_detail_counts;
+        std::vector<std::pair<unsigned int*, TextureImage>> textures;
+    };
+
+    std::vector<std::shared_ptr<Obj3D>> objects;
+    std::vector<Job> jobs;
+    size_t file_count = 0;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next_job{0};
+
+    std::mutex finished_mutex;
+    std::vector<size_t> finished;       // job indices ready for upload
+    size_t ready_objects = 0;
+
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::steady_clock::time_point end;
+
+    void work();
+    void prepare(Job& job);
+    void upload(Job& job);
+};
@@ -0,0 +1,239 @@
+#include <iostream>
+#include <charconv>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "scene_manifest.h"
+#include "mapped_file.h"
+
+namespace {
+
+// Walks the mapped text once; words and numbers are read in place, without
+// copying lines into streams
+class LineCursor {
+public:
+    LineCursor(const char* begin, const char* end) : next(begin), end(end) {}
+
+    int line_number = 0;
+
+    bool next_line() {
+        while (next < end) {
+            line = next;
+            while (next < end && *next != '\n') next++;
+            line_end = next;
+            if (next < end) next++;
+            line_number++;
+            // Strip the comment, skip blank lines
+            for (const char* c = line; c < line_end; c++) {
+                if (*c == '#') {
+                    line_end = c;
+                    break;
+                }
+            }
+            if (!at_end()) return true;
+        }
+        return false;
+    }
+
+    bool at_end() {
+        while (line < line_end && (*line == ' ' || *line == '\t' || *line == '\r')) line++;
+        return line >= line_end;
+    }
+
+    bool word(std::string_view& out) {
+        if (at_end()) return false;
+        const char* start = line;
+        while (line < line_end && *line != ' ' && *line != '\t' && *line != '\r') line++;
+        out = std::string_view(start, line - start);
+        return true;
+    }
+
+    template <typename T>
+    bool number(T& out) {
+        if (at_end()) return false;
+        auto result = std::from_chars(line, line_end, out);
+        if (result.ec != std::errc()) return false;
+        line = result.ptr;
+        return true;
+    }
+
+    bool vec3(glm::vec3& out) { return number(out.x) && number(out.y) && number(out.z); }
+
+private:
+    const char* next;
+    const char* end;
+    const char* line = nullptr;
+    const char* line_end = nullptr;
+};
+
+std::string resolve(const std::string& directory, std::string_view path) {
+    std::filesystem::path p(path);
+    if (p.is_absolute() || directory.empty()) return p.lexically_normal().generic_string();
+    return (std::filesystem::path(directory) / p).lexically_normal().generic_string();
+}
+
+}
+
+glm::mat4 ManifestObject::transform() const {
+    glm::mat4 m = glm::translate(glm::mat4(1.0f), position);
+    m = glm::rotate(m, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+    m = glm::rotate(m, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+    m = glm::rotate(m, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(m, scale);
+}
+
+bool SceneManifest::load(const std::string& filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        std::cerr << "Could not open scene manifest " << filename << std::endl;
+        return false;
+    }
+    objects.clear();
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    if (std::filesystem::path(filename).extension() == ".cfg") {
+        return parse_legacy(begin, end, filename);
+    }
+    return parse(begin, end, filename);
+}
+
+size_t SceneManifest::instance_count() const {
+    size_t count = 0;
+    for (const auto& object : objects) {
+        count += 1 + object.instances.size();
+    }
+    return count;
+}
+
+bool SceneManifest::parse(const char* begin, const char* end, const std::string& filename) {
+    std::string directory = std::filesystem::path(filename).parent_path().generic_string();
+    LineCursor cursor(begin, end);
+    std::string_view directive, value;
+
+    auto fail = [&](const char* message) {
+        std::cerr << filename << ":" << cursor.line_number << ": " << message << std::endl;
+        return false;
+    };
+
+    if (!cursor.next_line() || !cursor.word(directive) || directive != "scene" || !cursor.number(version)) {
+        return fail("expected 'scene <version>'");
+    }
+    if (version > VERSION) {
+        return fail("manifest version is newer than this build supports");
+    }
+
+    // Large scenes repeat a few files many times; normalize each path once
+    std::unordered_map<std::string_view, std::string> resolved;
+    auto resolve_cached = [&](std::string_view path) -> const std::string& {
+        auto it = resolved.find(path);
+        if (it == resolved.end()) it = resolved.emplace(path, resolve(directory, path)).first;
+        return it->second;
+    };
+
+    ManifestObject* object = nullptr;
+    while (cursor.next_line()) {
+        cursor.word(directive);
+        bool ok = true;
+
+        if (directive == "object") {
+            std::string_view name, path;
+            ok = cursor.word(name) && cursor.word(path);
+            if (ok) {
+                objects.emplace_back();
+                object = &objects.back();
+                object->name = std::string(name);
+                object->obj_file = resolve_cached(path);
+            }
+        }
+        else if (directive == "track" || directive == "track_document" || directive == "track_animation" ||
+                 directive == "track_keyframes" || directive == "car") {
+            ok = cursor.word(value);
+            if (ok) {
+                std::string path = resolve(directory, value);
+                if (directive == "track") track_obj = path;
+                else if (directive == "track_document") track_document = path;
+                else if (directive == "track_animation") track_animation = path;
+                else if (directive == "track_keyframes") track_keyframes = path;
+                else car = path;
+            }
+        }
+        else if (!object) {
+            std::cerr << filename << ":" << cursor.line_number << ": '" << directive
+                      << "' outside an object, ignored" << std::endl;
+            continue;
+        }
+        else if (directive == "flags") {
+            while (ok && cursor.word(value)) {
+                if (value == "selectable") object->selectable = true;
+                else if (value == "collidable") object->collidable = true;
+                else if (value == "eliminable") object->eliminable = true;
+                else ok = false;
+            }
+        }
+        else if (directive == "position") ok = cursor.vec3(object->position);
+        else if (directive == "rotation") ok = cursor.vec3(object->rotation);
+        else if (directive == "scale") {
+            ok = cursor.number(object->scale.x);
+            object->scale.y = object->scale.z = object->scale.x;
+            if (ok && !cursor.at_end()) ok = cursor.number(object->scale.y) && cursor.number(object->scale.z);
+        }
+        else if (directive == "priority") ok = cursor.number(object->priority);
+        else if (directive == "parent") {
+            ok = cursor.word(value) && value != object->name;
+            if (ok) object->parent = std::string(value);
+        }
+        else if (directive == "cache") {
+            ok = cursor.word(value) && (value == "shared" || value == "private");
+            if (ok) object->cache = value == "shared" ? ManifestObject::SHARED : ManifestObject::PRIVATE;
+        }
+        else if (directive == "instance") {
+            glm::vec3 position;
+            float yaw = 0.0f, scale = 1.0f;
+            ok = cursor.vec3(position);
+            if (ok && !cursor.at_end()) ok = cursor.number(yaw);
+            if (ok && !cursor.at_end()) ok = cursor.number(scale);
+            if (ok) {
+                glm::mat4 m = glm::translate(glm::mat4(1.0f), position);
+                m = glm::rotate(m, glm::radians(yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+                object->instances.push_back(glm::scale(m, glm::vec3(scale)));
+            }
+        }
+        else {
+            // Newer minor additions are skipped so older builds still load the rest
+            std::cerr << filename << ":" << cursor.line_number << ": unknown directive '" << directive
+                      << "', ignored" << std::endl;
+            continue;
+        }
+
+        if (!ok) return fail("malformed line");
+    }
+    return true;
+}
+
+bool SceneManifest::parse_legacy(const char* begin, const char* end, const std::string& filename) {
+    // Paths in config.cfg are relative to the working directory, as before
+    LineCursor cursor(begin, end);
+    while (cursor.next_line()) {
+        std::string_view name, path;
+        int selectable, collidable, eliminable;
+        if (!cursor.word(name)) continue;
+        // config.cfg starts with the object count, which the lines themselves make redundant
+        if (cursor.at_end() && name.find_first_not_of("0123456789") == std::string_view::npos) continue;
+        if (!(cursor.word(path) && cursor.number(selectable) && cursor.number(collidable) && cursor.number(eliminable))) {
+            std::cerr << "Warning: " << filename << ":" << cursor.line_number
+                      << ": skipped, expected 'name file selectable collidable eliminable'" << std::endl;
+            continue;
+        }
+        objects.emplace_back();
+        ManifestObject& object = objects.back();
+        object.name = std::string(name);
+        object.obj_file = std::string(path);
+        object.selectable = selectable;
+        object.collidable = collidable;
+        object.eliminable = eliminable;
+    }
+    version = 0;
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// One entry of the scene manifest: a mesh placed once at its own transform and
+// optionally again at every instance transform, all sharing the loaded mesh.
+struct ManifestObject {
+    enum Cache { SHARED, PRIVATE };
+
+    std::string name;
+    std::string obj_file;
+    bool selectable = false;
+    bool collidable = false;
+    bool eliminable = false;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 rotation = glm::vec3(0.0f);       // degrees around x, y, z
+    glm::vec3 scale = glm::vec3(1.0f);
+    std::vector<glm::mat4> instances;
+    int priority = 0;                           // lower loads first
+    Cache cache = SHARED;                       // PRIVATE meshes skip the shared mesh registry
+    std::string parent;                         // transforms are relative to this object when set
+
+    glm::mat4 transform() const;
+};
+
+// Scene description (.rscene). Plain text, one directive per line, '#' starts a
+// comment; the first directive must be "scene <version>". Paths are relative
+// to the manifest's directory.
+//
+//   scene 1
+//   track track/exported_track.obj          exported mesh, used when the document has none
+//   track_document track/track.rtrk
+//   track_animation track/animation_path.txt
+//   track_keyframes track/animation_path.rkey
+//   car track/car.obj
+//   object <name> <file.obj>                starts an object, the lines below apply to it
+//     flags selectable collidable eliminable
+//     position x y z | rotation x y z | scale s | scale x y z
+//     priority n                            load order, lower first (default 0)
+//     cache shared|private
+//     instance x y z [yaw_degrees [scale]]  one more copy of the mesh
+//     parent <name>                         follow an earlier object, "track" or "car";
+//                                           position, rotation, scale and instances become relative to it
+//
+// A legacy config.cfg (name path selectable collidable eliminable per line)
+// is read when the file has a .cfg extension.
+class SceneManifest {
+public:
+    static const uint32_t VERSION = 1;
+
+    uint32_t version = VERSION;
+    std::string track_obj = "../objs/track/exported_track.obj";
+    std::string track_document = "../objs/track/track.rtrk";
+    std::string track_animation = "../objs/track/animation_path.txt";
+    std::string track_keyframes = "../objs/track/animation_path.rkey";
+    std::string car = "../objs/track/car.obj";
+    std::vector<ManifestObject> objects;
+
+    bool load(const std::string& filename);
+    size_t instance_count() const;
+
+private:
+    bool parse(const char* begin, const char* end, const std::string& filename);
+    bool parse_legacy(const char* begin, const char* end, const std::string& filename);
+};
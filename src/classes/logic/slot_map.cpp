@@ -0,0 +1,42 @@
+#include "slot_map.h"
+
+const uint32_t SlotMap::INVALID_INDEX;
+
+SlotHandle SlotMap::insert() {
+    uint32_t slot;
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    } else {
+        slot = (uint32_t)slots.size();
+        slots.emplace_back();
+    }
+    slots[slot].index = (uint32_t)dense_slots.size();
+    dense_slots.push_back(slot);
+    return {slot, slots[slot].generation};
+}
+
+uint32_t SlotMap::erase(SlotHandle handle) {
+    uint32_t index = index_of(handle);
+    if (index == INVALID_INDEX) return INVALID_INDEX;
+
+    uint32_t last_slot = dense_slots.back();
+    dense_slots[index] = last_slot;
+    slots[last_slot].index = index;
+    dense_slots.pop_back();
+
+    slots[handle.slot].index = INVALID_INDEX;
+    slots[handle.slot].generation++;
+    free_slots.push_back(handle.slot);
+    return index;
+}
+
+void SlotMap::clear() {
+    // Keep the generations so handles from before the clear stay invalid
+    for (uint32_t slot : dense_slots) {
+        slots[slot].index = INVALID_INDEX;
+        slots[slot].generation++;
+        free_slots.push_back(slot);
+    }
+    dense_slots.clear();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Reference to an entry of a SlotMap. The generation tells a handle to a
+// removed entry apart from a newer entry that reuses the same slot.
+struct SlotHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const SlotHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// Generational slot map over a dense array kept by the caller. Entries are
+// numbered 0..size()-1 with no holes; insert() adds one at the end and
+// erase() moves the last entry into the freed place, so the caller mirrors
+// both with push_back and swap-with-last + pop_back on its own arrays.
+class SlotMap {
+public:
+    static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+    SlotHandle insert();
+    // Returns the dense index that was freed; the caller moves its last entry there
+    uint32_t erase(SlotHandle handle);
+    void clear();
+
+    uint32_t index_of(SlotHandle handle) const {
+        if (handle.slot >= slots.size() || slots[handle.slot].generation != handle.generation) return INVALID_INDEX;
+        return slots[handle.slot].index;
+    }
+    bool contains(SlotHandle handle) const { return index_of(handle) != INVALID_INDEX; }
+    SlotHandle handle_at(uint32_t index) const { return {dense_slots[index], slots[dense_slots[index]].generation}; }
+    size_t size() const { return dense_slots.size(); }
+
+private:
+    struct Slot {
+        uint32_t index = INVALID_INDEX;     // dense index, INVALID_INDEX while free
+        uint32_t generation = 0;
+    };
+    std::vector<Slot> slots;
+    std::vector<uint32_t> free_slots;
+    std::vector<uint32_t> dense_slots;      // dense index -> slot
+};
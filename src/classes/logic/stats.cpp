@@ -0,0 +1,210 @@
+#include <cstdlib>
+#include <new>
+#include <mutex>
+#include <unordered_map>
+#include <iostream>
+#include <algorithm>
+
+#include "stats.h"
+
+std::atomic<int64_t> Stats::values[Stats::COUNTER_COUNT];
+int64_t Stats::last_frame[Stats::COUNTER_COUNT] = {};
+uint64_t Stats::frame = 0;
+Stats::DumpState Stats::dump;
+
+namespace {
+
+std::mutex events_mutex;
+std::vector<std::string> pending_events;
+
+std::mutex textures_mutex;
+std::unordered_map<unsigned int, size_t> texture_sizes;
+
+const char* counter_names[Stats::COUNTER_COUNT] = {
+    "draw_calls",
+    "state_changes",
+    "triangles",
+    "collision_pairs",
+    "allocations",
+    "allocated_bytes",
+    "buffer_upload_bytes",
+    "live_bullets",
+    "gpu_buffer_bytes",
+    "texture_bytes",
+};
+
+}
+
+// Counting allocator hook: every operator new/new[] in the program ends up here.
+// The counters are lock-free atomics, so this is safe before main and on any thread.
+void* operator new(std::size_t size) {
+    Stats::add(Stats::ALLOCATIONS);
+    Stats::add(Stats::ALLOCATED_BYTES, (int64_t)size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    Stats::add(Stats::ALLOCATIONS);
+    Stats::add(Stats::ALLOCATED_BYTES, (int64_t)size);
+    return std::malloc(size ? size : 1);
+}
+
+// Kept out of line so GCC does not see the new/free pairing and warn -Wmismatched-new-delete
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { ::operator delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { ::operator delete(p); }
+
+// Over-aligned types (alignas above the default) come through these instead.
+// aligned_alloc wants the size rounded up to a multiple of the alignment.
+static void* counted_aligned_alloc(std::size_t size, std::align_val_t alignment) noexcept {
+    Stats::add(Stats::ALLOCATIONS);
+    Stats::add(Stats::ALLOCATED_BYTES, (int64_t)size);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    return std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* p = counted_aligned_alloc(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_aligned_alloc(size, alignment);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept { ::operator delete(p, alignment); }
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { ::operator delete(p, alignment); }
+
+const char* Stats::name(Counter counter) {
+    return counter_names[counter];
+}
+
+void Stats::texture_created(unsigned int texture, size_t bytes) {
+    if (!texture) return;
+    std::lock_guard<std::mutex> lock(textures_mutex);
+    size_t& size = texture_sizes[texture];
+    add(TEXTURE_BYTES, (int64_t)bytes - (int64_t)size);
+    size = bytes;
+}
+
+void Stats::texture_released(unsigned int texture) {
+    if (!texture) return;
+    std::lock_guard<std::mutex> lock(textures_mutex);
+    auto it = texture_sizes.find(texture);
+    if (it == texture_sizes.end()) return;
+    add(TEXTURE_BYTES, -(int64_t)it->second);
+    texture_sizes.erase(it);
+}
+
+void Stats::note_event(const std::string& event) {
+    if (!dump.file.is_open()) return;
+    std::lock_guard<std::mutex> lock(events_mutex);
+    pending_events.push_back(event);
+}
+
+bool Stats::open_dump(const std::string& filename, int interval_frames) {
+    close_dump();
+    dump.file.open(filename, std::ios::out | std::ios::trunc);
+    if (!dump.file.is_open()) {
+        std::cerr << "Could not open stats file " << filename << std::endl;
+        return false;
+    }
+    std::string extension = filename.substr(std::min(filename.find_last_of('.'), filename.size()));
+    dump.json = extension == ".json";
+    dump.interval = std::max(interval_frames, 1);
+    dump.frames = 0;
+    dump.rows = 0;
+
+    if (dump.json) {
+        dump.file << "[\n";
+    } else {
+        dump.file << "frame,frame_ms_avg,frame_ms_max";
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            dump.file << "," << counter_names[i];
+        }
+        dump.file << ",events\n";
+    }
+    std::cout << "Writing stats every " << dump.interval << " frames to " << filename << std::endl;
+    return true;
+}
+
+void Stats::close_dump() {
+    if (!dump.file.is_open()) return;
+    if (dump.frames > 0) write_row();
+    if (dump.json) dump.file << "\n]\n";
+    dump.file.close();
+}
+
+void Stats::end_frame(double frame_ms) {
+    frame++;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        Counter counter = (Counter)i;
+        last_frame[i] = is_gauge(counter) ? get(counter) : values[i].exchange(0, std::memory_order_relaxed);
+    }
+    if (!dump.file.is_open()) return;
+
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        if (is_gauge((Counter)i)) dump.sums[i] = last_frame[i];
+        else dump.sums[i] += last_frame[i];
+    }
+    dump.frame_ms_sum += frame_ms;
+    dump.frame_ms_max = std::max(dump.frame_ms_max, frame_ms);
+    if (++dump.frames >= dump.interval) write_row();
+}
+
+void Stats::write_row() {
+    {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        dump.events.swap(pending_events);
+        pending_events.clear();
+    }
+
+    double frames = dump.frames;
+    if (dump.json) {
+        dump.file << (dump.rows > 0 ? ",\n" : "") << "  {\"frame\": " << frame << ", \"frame_ms_avg\": "
+                  << dump.frame_ms_sum / frames << ", \"frame_ms_max\": " << dump.frame_ms_max;
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            double value = is_gauge((Counter)i) ? dump.sums[i] : dump.sums[i] / frames;
+            dump.file << ", \"" << counter_names[i] << "\": " << value;
+        }
+        dump.file << ", \"events\": [";
+        for (size_t i = 0; i < dump.events.size(); i++) {
+            std::string event = dump.events[i];
+            std::replace(event.begin(), event.end(), '"', '\'');
+            std::replace(event.begin(), event.end(), '\\', '/');
+            dump.file << (i > 0 ? ", " : "") << "\"" << event << "\"";
+        }
+        dump.file << "]}";
+    } else {
+        dump.file << frame << "," << dump.frame_ms_sum / frames << "," << dump.frame_ms_max;
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            double value = is_gauge((Counter)i) ? dump.sums[i] : dump.sums[i] / frames;
+            dump.file << "," << value;
+        }
+        dump.file << ",\"";
+        for (size_t i = 0; i < dump.events.size(); i++) {
+            std::string event = dump.events[i];
+            std::replace(event.begin(), event.end(), '"', '\'');
+            dump.file << (i > 0 ? "; " : "") << event;
+        }
+        dump.file << "\"\n";
+    }
+    dump.file.flush();
+
+    dump.rows++;
+    dump.frames = 0;
+    dump.frame_ms_sum = 0.0;
+    dump.frame_ms_max = 0.0;
+    std::fill(std::begin(dump.sums), std::end(dump.sums), 0);
+    dump.events.clear();
+}
+
+void Stats::print(std::ostream& out) {
+    out << "Frame " << frame << ":";
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        out << " " << counter_names[i] << "=" << last_frame[i];
+    }
+    out << std::endl;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+
+// Runtime counters shared by the renderer, loaders and BulletManager. Frame
+// counters (draw calls, triangles, ...) are summed while a frame runs and
+// cleared by end_frame(); gauges (live bullets, GPU/texture bytes) hold their
+// value until changed. Heap allocations are counted by the global operator
+// new in stats.cpp (plain and over-aligned), from every thread.
+//
+// With a dump file open, end_frame() writes one row per interval frames:
+// frame counters averaged over the interval, gauges at their latest value,
+// the worst frame time and any events noted in the interval (loads, ...), so
+// hitches can be matched to what caused them. The format follows the file
+// extension: .json writes an array of objects, anything else CSV.
+class Stats {
+public:
+    enum Counter {
+        DRAW_CALLS,
+        STATE_CHANGES,          // VAO, material and instancing switches
+        TRIANGLES,
+        COLLISION_PAIRS,
+        ALLOCATIONS,
+        ALLOCATED_BYTES,
+        BUFFER_UPLOAD_BYTES,
+        LIVE_BULLETS,
+        GPU_BUFFER_BYTES,
+        TEXTURE_BYTES,
+        COUNTER_COUNT
+    };
+
+    static const char* name(Counter counter);
+    static bool is_gauge(Counter counter) { return counter >= LIVE_BULLETS; }
+
+    static void add(Counter counter, int64_t amount = 1) {
+        values[counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+    static void set(Counter counter, int64_t value) {
+        values[counter].store(value, std::memory_order_relaxed);
+    }
+    static int64_t get(Counter counter) { return values[counter].load(std::memory_order_relaxed); }
+    // Value from the last finished frame, for frame counters
+    static int64_t last(Counter counter) { return last_frame[counter]; }
+
+    // Texture sizes are remembered per handle so releasing one can update TEXTURE_BYTES
+    static void texture_created(unsigned int texture, size_t bytes);
+    static void texture_released(unsigned int texture);
+
+    // Short label written with the next dump row, e.g. "load objs/car.obj"
+    static void note_event(const std::string& event);
+
+    static bool open_dump(const std::string& filename, int interval_frames);
+    static void close_dump();
+    static void end_frame(double frame_ms);
+
+    static uint64_t frame_index() { return frame; }
+    static void print(std::ostream& out);
+
+private:
+    static std::atomic<int64_t> values[COUNTER_COUNT];
+    static int64_t last_frame[COUNTER_COUNT];
+    static uint64_t frame;
+
+    struct DumpState {
+        std::ofstream file;
+        bool json = false;
+        int interval = 1;
+        int frames = 0;
+        size_t rows = 0;
+        int64_t sums[COUNTER_COUNT] = {};
+        double frame_ms_sum = 0.0;
+        double frame_ms_max = 0.0;
+        std::vector<std::string> events;
+    };
+    static DumpState dump;
+
+    static void write_row();
+};
@@ -0,0 +1,228 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "buffered_writer.h"
+#include "checksum.h"
+#include "mapped_file.h"
+#include "track_document.h"
+
+namespace {
+
+size_t align_section(size_t offset) {
+    return (offset + 15) & ~size_t(15);
+}
+
+void append_section(std::string& buffer, TrackFileSection& section, const void* data, size_t count, uint32_t stride) {
+    buffer.resize(align_section(buffer.size()), '\0');
+    section.offset = buffer.size();
+    section.count = count;
+    section.stride = stride;
+    section.checksum = TrackDocument::checksum(data, count * stride);
+    buffer.append(static_cast<const char*>(data), count * stride);
+}
+
+const char* section_data(const MappedFile& file, const TrackFileSection& section, const char* name) {
+    if (section.count == 0) return nullptr;
+    // Compared piecewise so a corrupt header cannot wrap the end offset around
+    if (section.stride == 0 || section.offset > file.size() ||
+        section.count > (file.size() - section.offset) / section.stride) {
+        std::cerr << "Error: Track file section '" << name << "' is truncated" << std::endl;
+        return nullptr;
+    }
+    const char* data = file.data() + section.offset;
+    if (TrackDocument::checksum(data, section.count * section.stride) != section.checksum) {
+        std::cerr << "Error: Track file section '" << name << "' failed checksum" << std::endl;
+        return nullptr;
+    }
+    return data;
+}
+
+bool read_header(const MappedFile& file, const std::string& filename, TrackFileHeader& header) {
+    if (file.size() < sizeof(TrackFileHeader)) {
+        std::cerr << "Error: " << filename << " is not a track file" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(TrackFileHeader));
+    if (std::memcmp(header.magic, "RTRK", 4) != 0 || header.version != 2) {
+        std::cerr << "Error: " << filename << " is not a supported track file" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+uint32_t TrackDocument::checksum(const void* data, size_t bytes) {
+    return fnv1a(data, bytes);
+}
+
+bool TrackDocument::save(const std::string& filename, const TrackEditor& editor, bool cache_geometry) {
+    TrackFileHeader header;
+    header.steps_per_segment = editor.center_spline.getStepsPerSegment();
+    header.track_width = editor.track_width;
+
+    BufferedWriter file;
+    file.buffer.resize(sizeof(TrackFileHeader), '\0');
+
+    append_section(file.buffer, header.control_points, editor.control_points.data(),
+                   editor.control_points.size(), sizeof(glm::vec2));
+
+    append_section(file.buffer, header.point_attributes, editor.point_attributes.data(),
+                   editor.point_attributes.size(), sizeof(TrackPointAttributes));
+    append_section(file.buffer, header.profile, editor.profile.data(),
+                   editor.profile.size(), sizeof(ProfileVertex));
+
+    std::string material_ref = editor.material ? editor.material->diffuseMap : "road.jpg";
+    append_section(file.buffer, header.material, material_ref.data(), material_ref.size(), 1);
+
+    if (cache_geometry && editor.control_points.size() >= 4) {
+        TrackEditor snapshot = editor;
+        auto mesh = std::make_shared<Mesh>();
+        snapshot.generate_track_mesh(mesh);
+
+        auto centerline = snapshot.center_spline.evaluateCurve();
+        append_section(file.buffer, header.centerline, centerline.data(), centerline.size(), sizeof(glm::vec3));
+        header.flags |= FLAG_CENTERLINE;
+
+        // The generator's faces index verts/mappings/normals from 0 (export_track_OBJ adds
+        // the 1 on writing), so the triangle list is built from them directly rather than
+        // through Mesh::process_data, which expects OBJ's 1-based indices
+        std::vector<float> interleaved;
+        glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+        auto append_vertex = [&](const Face& face, size_t j) {
+            const glm::vec3& v = mesh->verts[face.verts[j]];
+            const glm::vec2& uv = mesh->mappings[face.textures[j]];
+            const glm::vec3& n = mesh->normals[face.normals[j]];
+            interleaved.insert(interleaved.end(), {v.x, v.y, v.z, uv.x, uv.y, n.x, n.y, n.z});
+            min = glm::min(min, v);
+            max = glm::max(max, v);
+        };
+        for (const auto& group : mesh->groups) {
+            for (const auto& face : group->faces) {
+                for (size_t j = 1; j + 1 < face->verts.size(); j++) {
+                    append_vertex(*face, 0);
+                    append_vertex(*face, j);
+                    append_vertex(*face, j + 1);
+                }
+            }
+        }
+        size_t vertex_count = interleaved.size() / 8;
+        if (vertex_count > 0) {
+            append_section(file.buffer, header.vertices, interleaved.data(),
+                           vertex_count, 8 * sizeof(float));
+            header.flags |= FLAG_MESH;
+            std::memcpy(header.bounds_min, &min.x, sizeof(header.bounds_min));
+            std::memcpy(header.bounds_max, &max.x, sizeof(header.bounds_max));
+        }
+    }
+
+    std::memcpy(&file.buffer[0], &header, sizeof(TrackFileHeader));
+    if (!file.write_to_file(filename)) {
+        return false;
+    }
+    std::cout << "Saved track document " << filename << " (" << file.size() << " bytes)" << std::endl;
+    return true;
+}
+
+bool TrackDocument::load(const std::string& filename, TrackEditor& editor) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        std::cerr << "Error: Could not open track file " << filename << std::endl;
+        return false;
+    }
+    TrackFileHeader header;
+    if (!read_header(file, filename, header)) return false;
+    if (header.control_points.stride != sizeof(glm::vec2)) return false;
+
+    const char* points = section_data(file, header.control_points, "control_points");
+    if (!points && header.control_points.count) return false;
+
+    std::vector<glm::vec2> control_points(header.control_points.count);
+    if (points) {
+        std::memcpy(control_points.data(), points, header.control_points.count * sizeof(glm::vec2));
+    }
+
+    editor.track_width = header.track_width;
+    editor.center_spline.setStepsPerSegment(header.steps_per_segment);
+    editor.point_attributes.clear();
+    const char* attributes = section_data(file, header.point_attributes, "point_attributes");
+    if (attributes && header.point_attributes.stride == sizeof(TrackPointAttributes)
+        && header.point_attributes.count == control_points.size()) {
+        editor.point_attributes.resize(header.point_attributes.count);
+        std::memcpy(editor.point_attributes.data(), attributes, header.point_attributes.count * sizeof(TrackPointAttributes));
+    }
+    editor.set_control_points(control_points);
+
+    const char* profile = section_data(file, header.profile, "profile");
+    if (profile && header.profile.stride == sizeof(ProfileVertex) && header.profile.count >= 2) {
+        editor.profile.resize(header.profile.count);
+        std::memcpy(editor.profile.data(), profile, header.profile.count * sizeof(ProfileVertex));
+    }
+
+    const char* material_ref = section_data(file, header.material, "material");
+    if (material_ref) {
+        editor.material = std::make_shared<Material>();
+        editor.material->name = "track_material";
+        editor.material->diffuseMap.assign(material_ref, header.material.count);
+    }
+
+    std::cout << "Loaded track document " << filename << ": " << control_points.size() << " control points" << std::endl;
+    return true;
+}
+
+bool TrackDocument::load_geometry(const std::string& filename, std::shared_ptr<Obj3D> obj) {
+    auto begin = std::chrono::steady_clock::now();
+
+    MappedFile file;
+    if (!file.open(filename)) return false;
+    TrackFileHeader header;
+    if (!read_header(file, filename, header)) return false;
+    if (!(header.flags & FLAG_MESH) || header.vertices.stride != 8 * sizeof(float)) return false;
+
+    const char* vertices = section_data(file, header.vertices, "vertices");
+    if (!vertices) return false;
+
+    auto material = std::make_shared<Material>();
+    material->name = "TrackMaterial";
+    const char* material_ref = section_data(file, header.material, "material");
+    if (material_ref) {
+        material->diffuseMap.assign(material_ref, header.material.count);
+    }
+
+    auto group = std::make_shared<Group>("track");
+    group->material = material;
+    obj->mesh = std::make_shared<Mesh>();
+    obj->mesh->groups.push_back(group);
+    Obj3D::upload_group_buffers(group, reinterpret_cast<const float*>(vertices), header.vertices.count);
+    obj->buffers_created = true;
+
+    obj->bbox->min = glm::vec3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]);
+    obj->bbox->max = glm::vec3(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]);
+    obj->bbox->center = (obj->bbox->min + obj->bbox->max) * 0.5f;
+    obj->bbox->size = obj->bbox->max - obj->bbox->min;
+    obj->bbox->halfSize = obj->bbox->size * 0.5f;
+    obj->has_bounds = true;
+    obj->world_bounds_valid = false;
+    obj->sync();
+
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Mapped track geometry " << filename << ": " << header.vertices.count << " vertices in "
+              << std::chrono::duration<double, std::milli>(end - begin).count() << " ms" << std::endl;
+    return true;
+}
+
+bool TrackDocument::load_centerline(const std::string& filename, std::vector<glm::vec3>& centerline) {
+    MappedFile file;
+    if (!file.open(filename)) return false;
+    TrackFileHeader header;
+    if (!read_header(file, filename, header)) return false;
+    if (!(header.flags & FLAG_CENTERLINE) || header.centerline.stride != sizeof(glm::vec3)) return false;
+
+    const char* points = section_data(file, header.centerline, "centerline");
+    if (!points) return false;
+
+    centerline.resize(header.centerline.count);
+    std::memcpy(centerline.data(), points, header.centerline.count * sizeof(glm::vec3));
+    return true;
+}
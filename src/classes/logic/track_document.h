@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "track_editor.h"
+#include "../rendering/3D/obj3d.h"
+
+// Native track file (.rtrk). Holds the editable track (control points with
+// their width/bank/elevation, cross-section profile, tessellation, material) and optionally a cached centerline and
+// render-ready mesh so the viewer can map it without re-tessellating.
+//
+// Layout: TrackFileHeader followed by 16-byte aligned sections. Every
+// section carries an FNV-1a checksum of its bytes.
+
+struct TrackFileSection {
+    uint64_t offset = 0;
+    uint64_t count = 0;
+    uint32_t stride = 0;
+    uint32_t checksum = 0;
+};
+
+struct TrackFileHeader {
+    char magic[4] = {'R', 'T', 'R', 'K'};
+    uint32_t version = 2;
+    uint32_t flags = 0;
+    uint32_t steps_per_segment = 0;
+    float track_width = 1.0f;
+    float bounds_min[3] = {0.0f, 0.0f, 0.0f};
+    float bounds_max[3] = {0.0f, 0.0f, 0.0f};
+    uint32_t reserved = 0;
+    TrackFileSection control_points;    // glm::vec2
+    TrackFileSection point_attributes;  // TrackPointAttributes, one per control point
+    TrackFileSection profile;           // ProfileVertex
+    TrackFileSection material;          // char, diffuse map of the track material
+    TrackFileSection centerline;        // glm::vec3
+    TrackFileSection vertices;          // float[8] position/uv/normal, triangle list
+};
+
+class TrackDocument {
+public:
+    static constexpr uint32_t FLAG_CENTERLINE = 1u << 0;
+    static constexpr uint32_t FLAG_MESH = 1u << 1;
+
+    static bool save(const std::string& filename, const TrackEditor& editor, bool cache_geometry = true);
+    static bool load(const std::string& filename, TrackEditor& editor);
+
+    // Maps the cached mesh and uploads it straight from the mapping into a single group.
+    static bool load_geometry(const std::string& filename, std::shared_ptr<Obj3D> obj);
+    static bool load_centerline(const std::string& filename, std::vector<glm::vec3>& centerline);
+
+    static uint32_t checksum(const void* data, size_t bytes);
+};
@@ -6,46 +6,359 @@
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 
 #include "obj3dwriter.h"
+#include "buffered_writer.h"
+#include "checksum.h"
 #include "track_editor.h"
 
-void TrackEditor::add_control_point(const glm::vec2& point) {
-    control_points.push_back(point);
-    
+namespace {
+
+glm::vec3 rotate_about(const glm::vec3& v, const glm::vec3& axis, float angle) {
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    return v * c + glm::cross(axis, v) * s + axis * (glm::dot(axis, v) * (1.0f - c));
+}
+
+void resize_faces(std::vector<std::shared_ptr<Face>>& faces, size_t count) {
+    if (faces.size() > count) {
+        faces.resize(count);
+    }
+    while (faces.size() < count) {
+        faces.push_back(std::make_shared<Face>());
+    }
+}
+
+// Two triangles per profile edge between rings, written over reused Face objects
+void write_strip(std::vector<std::shared_ptr<Face>>& faces, size_t& f, int ring, int next_ring, int P) {
+    for (int k = 0; k + 1 < P; k++) {
+        int a = ring * P + k;
+        int b = ring * P + k + 1;
+        int c = next_ring * P + k;
+        int d = next_ring * P + k + 1;
+
+        Face& face1 = *faces[f++];
+        face1.verts = {a, c, b};
+        face1.textures = {a, c, b};
+        face1.normals = {a, c, b};
+
+        Face& face2 = *faces[f++];
+        face2.verts = {b, c, d};
+        face2.textures = {b, c, d};
+        face2.normals = {b, c, d};
+    }
+}
+
+}
+
+void TrackEditor::sync_spline() {
     std::vector<glm::vec3> points;
-    for (const auto& p : control_points) {
-        points.push_back(glm::vec3(p.x, 0.0f, p.y));
+    std::vector<glm::vec3> attributes;
+    points.reserve(control_points.size());
+    attributes.reserve(control_points.size());
+    for (size_t i = 0; i < control_points.size(); i++) {
+        const auto& p = control_points[i];
+        const auto& a = point_attributes[i];
+        points.push_back(glm::vec3(p.x, a.elevation, p.y));
+        attributes.push_back(glm::vec3(a.width, a.bank, 0.0f));
     }
     center_spline.set_control_points(points);
+    attribute_spline.set_control_points(attributes);
+    attribute_spline.setStepsPerSegment(center_spline.getStepsPerSegment());
+    layout_dirty = true;
+}
+
+void TrackEditor::sync_spline_point(size_t index) {
+    const auto& p = control_points[index];
+    const auto& a = point_attributes[index];
+    center_spline.setControlPoint(index, glm::vec3(p.x, a.elevation, p.y));
+    attribute_spline.setControlPoint(index, glm::vec3(a.width, a.bank, 0.0f));
+    mark_point_dirty(index);
+}
+
+// Control point k shapes spline segments k-2 .. k+1. Ranges that would wrap
+// around the start of the loop take the full rebuild path instead.
+void TrackEditor::mark_point_dirty(size_t index) {
+    int k = static_cast<int>(index);
+    int first = k - 2;
+    int last = k + 1;
+    if (first < 1 || last > static_cast<int>(control_points.size()) - 2) {
+        layout_dirty = true;
+        return;
+    }
+    dirty_first = dirty_first < 0 ? first : std::min(dirty_first, first);
+    dirty_last = std::max(dirty_last, last);
+}
+
+void TrackEditor::note_points_changed(size_t first, size_t last) {
+    revision++;
+    if (first > last) return;
+    points_changed_first = std::min(points_changed_first, first);
+    points_changed_last = std::max(points_changed_last, last);
+}
+
+void TrackEditor::note_samples_changed(size_t first, size_t last) {
+    revision++;
+    samples_changed_first = std::min(samples_changed_first, first);
+    samples_changed_last = std::max(samples_changed_last, last);
+}
+
+bool TrackEditor::take_point_changes(size_t& first, size_t& last) {
+    if (points_changed_first == SIZE_MAX || control_points.empty()) {
+        points_changed_first = SIZE_MAX;
+        return false;
+    }
+    first = points_changed_first;
+    last = std::min(points_changed_last, control_points.size() - 1);
+    points_changed_first = SIZE_MAX;
+    points_changed_last = 0;
+    return first <= last;
+}
+
+bool TrackEditor::take_sample_changes(size_t& first, size_t& last) {
+    if (samples_changed_first == SIZE_MAX || center_samples.empty()) {
+        samples_changed_first = SIZE_MAX;
+        return false;
+    }
+    first = samples_changed_first;
+    last = std::min(samples_changed_last, center_samples.size() - 1);
+    samples_changed_first = SIZE_MAX;
+    samples_changed_last = 0;
+    return first <= last;
+}
+
+void TrackEditor::add_control_point(const glm::vec2& point) {
+    control_points.push_back(point);
+    TrackPointAttributes attributes;
+    attributes.width = track_width;
+    point_attributes.push_back(attributes);
+    point_index.insert(static_cast<uint32_t>(control_points.size() - 1), point, attributes.elevation);
+    note_points_changed(control_points.size() - 1, control_points.size() - 1);
+    sync_spline();
 }
 
 void TrackEditor::pop_back_control_points(){
     if (control_points.size()) {
+        point_index.remove(static_cast<uint32_t>(control_points.size() - 1), control_points.back(),
+                           point_attributes.back().elevation);
         control_points.pop_back();
-        std::vector<glm::vec3> points;
-        for (const auto& p : control_points) {
-            points.push_back(glm::vec3(p.x, 0.0f, p.y));
-        }
-        center_spline.set_control_points(points);
+        point_attributes.pop_back();
+        revision++;
+        sync_spline();
     }
 }
 
 void TrackEditor::clear_control_points() {
     control_points.clear();
-    std::vector<glm::vec3> empty;
-    center_spline.set_control_points(empty);
+    point_attributes.clear();
+    point_index.clear();
+    revision++;
+    sync_spline();
+}
+
+void TrackEditor::set_control_points(const std::vector<glm::vec2>& points) {
+    control_points = points;
+    TrackPointAttributes attributes;
+    attributes.width = track_width;
+    point_attributes.resize(control_points.size(), attributes);
+    point_index.clear();
+    for (size_t i = 0; i < control_points.size(); i++) {
+        point_index.insert(static_cast<uint32_t>(i), control_points[i], point_attributes[i].elevation);
+    }
+    note_points_changed(0, control_points.size() - 1);
+    sync_spline();
+}
+
+void TrackEditor::set_point_attributes(size_t index, const TrackPointAttributes& attributes) {
+    if (index >= point_attributes.size()) return;
+    point_index.change_level(static_cast<uint32_t>(index), control_points[index],
+                             point_attributes[index].elevation, attributes.elevation);
+    point_attributes[index] = attributes;
+    note_points_changed(index, index);
+    sync_spline_point(index);
+}
+
+void TrackEditor::move_control_point(size_t index, const glm::vec2& point) {
+    if (index >= control_points.size()) return;
+    point_index.move(static_cast<uint32_t>(index), control_points[index], point, point_attributes[index].elevation);
+    control_points[index] = point;
+    note_points_changed(index, index);
+    sync_spline_point(index);
+}
+
+void TrackEditor::insert_control_point(size_t index, const glm::vec2& point) {
+    if (index > control_points.size()) return;
+    TrackPointAttributes attributes;
+    attributes.width = track_width;
+    if (!point_attributes.empty()) {
+        // Take the shape of the neighbours so splitting a segment does not change its width or bank
+        const auto& a = point_attributes[(index + point_attributes.size() - 1) % point_attributes.size()];
+        const auto& b = point_attributes[index % point_attributes.size()];
+        attributes.width = (a.width + b.width) * 0.5f;
+        attributes.bank = (a.bank + b.bank) * 0.5f;
+        attributes.elevation = (a.elevation + b.elevation) * 0.5f;
+    }
+    control_points.insert(control_points.begin() + index, point);
+    point_attributes.insert(point_attributes.begin() + index, attributes);
+    point_index.insert(static_cast<uint32_t>(index), point, attributes.elevation);
+    note_points_changed(index, control_points.size() - 1);
+    sync_spline();
+}
+
+void TrackEditor::remove_control_point(size_t index) {
+    if (index >= control_points.size()) return;
+    point_index.remove(static_cast<uint32_t>(index), control_points[index], point_attributes[index].elevation);
+    control_points.erase(control_points.begin() + index);
+    point_attributes.erase(point_attributes.begin() + index);
+    note_points_changed(index, control_points.size() - 1);
+    sync_spline();
+}
+
+int TrackEditor::nearest_control_point(const glm::vec2& point, float radius, float elevation) const {
+    return point_index.nearest(point, radius, control_points, elevation);
+}
+
+int TrackEditor::nearest_segment(const glm::vec2& point, float radius) const {
+    int steps = center_spline.getStepsPerSegment();
+    size_t samples = static_cast<size_t>(control_points.size()) * steps;
+    if (control_points.size() < 4 || center_samples.size() != samples + 1) return -1;
+
+    int best = -1;
+    float best_distance = radius * radius;
+    for (size_t i = 0; i < samples; i++) {
+        glm::vec2 d = glm::vec2(center_samples[i].x, center_samples[i].z) - point;
+        float distance = glm::dot(d, d);
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = static_cast<int>(i);
+        }
+    }
+    // Segment i runs between control points i and i + 1
+    return best < 0 ? -1 : best / steps + 1;
+}
+
+// Central difference of the samples; the duplicated closing sample makes the
+// two ends one-sided, which every caller has to agree on.
+glm::vec3 TrackEditor::frame_tangent(size_t i) const {
+    size_t n = center_samples.size();
+    glm::vec3 prev = center_samples[(i - 1 + n) % n];
+    glm::vec3 next = center_samples[(i + 1) % n];
+    return glm::normalize(next - prev);
+}
+
+// One double reflection step (Wang et al. 2008): carries the up vector of
+// sample i over to sample i + 1 with minimal rotation.
+glm::vec3 TrackEditor::transport_frame(size_t i, const glm::vec3& r) const {
+    const glm::vec3& t = frame_tangents[i];
+
+    glm::vec3 v1 = center_samples[i + 1] - center_samples[i];
+    float c1 = glm::dot(v1, v1);
+    if (c1 < 1e-12f) {
+        return r;
+    }
+    glm::vec3 rL = r - v1 * (2.0f / c1 * glm::dot(v1, r));
+    glm::vec3 tL = t - v1 * (2.0f / c1 * glm::dot(v1, t));
+
+    glm::vec3 v2 = frame_tangents[i + 1] - tL;
+    float c2 = glm::dot(v2, v2);
+    return c2 < 1e-12f ? rL : rL - v2 * (2.0f / c2 * glm::dot(v2, rL));
+}
+
+glm::vec3 TrackEditor::banked_up(size_t i) const {
+    float bank = attribute_samples[i].y;
+    if (bank == 0.0f) return frame_bases[i];
+    return glm::normalize(rotate_about(frame_bases[i], frame_tangents[i], bank));
+}
+
+// Rotation-minimising frames along the sampled centerline. The twist left over
+// when the loop closes is spread evenly over the samples so the seam lines up.
+void TrackEditor::compute_frames() {
+    size_t n = center_samples.size();
+    frame_tangents.resize(n);
+    frame_bases.resize(n);
+    frame_ups.resize(n);
+
+    for (size_t i = 0; i < n; i++) {
+        frame_tangents[i] = frame_tangent(i);
+    }
+
+    const glm::vec3 world_up(0.0f, 1.0f, 0.0f);
+    glm::vec3 t0 = frame_tangents[0];
+    glm::vec3 r0 = world_up - t0 * glm::dot(t0, world_up);
+    frame_bases[0] = glm::dot(r0, r0) > 1e-12f ? glm::normalize(r0) : glm::vec3(1.0f, 0.0f, 0.0f);
+
+    for (size_t i = 0; i + 1 < n; i++) {
+        frame_bases[i + 1] = transport_frame(i, frame_bases[i]);
+    }
+
+    glm::vec3 r_end = frame_bases[n - 1] - t0 * glm::dot(t0, frame_bases[n - 1]);
+    float closure = std::atan2(glm::dot(glm::cross(r_end, frame_bases[0]), t0), glm::dot(r_end, frame_bases[0]));
+    float twist_scale = n > 1 ? closure / static_cast<float>(n - 1) : 0.0f;
+
+    for (size_t i = 0; i < n; i++) {
+        float roll = twist_scale * static_cast<float>(i);
+        if (roll != 0.0f) {
+            frame_bases[i] = glm::normalize(rotate_about(frame_bases[i], frame_tangents[i], roll));
+        }
+        frame_ups[i] = banked_up(i);
+    }
+}
+
+void TrackEditor::emit_ring(Mesh& mesh, size_t ring, size_t source, int profile_count) const {
+    const float textureScale = 0.2f;
+    const glm::vec3& center = center_samples[source];
+    const glm::vec3& up = frame_ups[source];
+    glm::vec3 side = glm::normalize(glm::cross(frame_tangents[source], up));
+    float half_width = attribute_samples[source].x * 0.5f;
+    float along = static_cast<float>(source) * textureScale;
+
+    size_t first = ring * profile_count;
+    for (int k = 0; k < profile_count; k++) {
+        const ProfileVertex& pv = profile[k];
+        mesh.verts[first + k] = center + side * (pv.lateral * half_width) + up * pv.height;
+        mesh.mappings[first + k] = glm::vec2(along, pv.v);
+        mesh.normals[first + k] = glm::normalize(side * profile_normals[k].x + up * profile_normals[k].y);
+    }
+}
+
+bool TrackEditor::can_update_partial(const std::shared_ptr<Mesh>& mesh) const {
+    if (layout_dirty || built_mesh.lock() != mesh) return false;
+    if (built_lod_levels != lod_levels || built_chunk_length != chunk_length) return false;
+    if (built_profile.size() != profile.size()) return false;
+    for (size_t k = 0; k < profile.size(); k++) {
+        if (built_profile[k].lateral != profile[k].lateral || built_profile[k].height != profile[k].height ||
+            built_profile[k].v != profile[k].v) {
+            return false;
+        }
+    }
+    size_t samples = control_points.size() * center_spline.getStepsPerSegment() + 1;
+    return center_samples.size() == samples && mesh->verts.size() == samples * profile.size();
 }
 
 void TrackEditor::generate_track_mesh(std::shared_ptr<Mesh> mesh) {
-    float textureScale = 0.2f; 
     if (control_points.size() < 4) {
         std::cout << "Need at least 4 control points for track generation" << std::endl;
         return;
     }
+    if (profile.size() < 2) {
+        std::cout << "Track profile needs at least 2 vertices" << std::endl;
+        return;
+    }
 
-    auto centerPoints = center_spline.evaluateCurve();
-    if (centerPoints.size() < 2) {
+    if (can_update_partial(mesh)) {
+        if (dirty_first >= 0) {
+            update_partial(*mesh);
+        } else {
+            chunks_rebuilt = 0;
+        }
+        last_build_partial = true;
+        return;
+    }
+
+    center_spline.evaluateCurve(center_samples);
+    attribute_spline.evaluateCurve(attribute_samples);
+    if (center_samples.size() < 2 || attribute_samples.size() != center_samples.size()) {
         std::cout << "Not enough curve points generated" << std::endl;
         return;
     }
@@ -57,112 +370,269 @@ void TrackEditor::generate_track_mesh(std::shared_ptr<Mesh> mesh) {
         material->diffuseMap = texture_path;
     }
 
-    if (!mesh->groups.size()) {
-        auto group = std::make_shared<Group>("track_group");
-        group->material = material;
-        mesh->groups.push_back(group);
-    }
-
-    mesh->verts.clear();
-    mesh->mappings.clear();
-    mesh->normals.clear();
     mesh->processed_verts.clear();
     mesh->processed_mappings.clear();
     mesh->processed_normals.clear();
 
-    std::vector<glm::vec3> innerPoints;
-    std::vector<glm::vec3> outerPoints;
-    std::vector<glm::vec3> tangents;
-    std::vector<glm::vec3> normals;
+    compute_frames();
 
-    for (size_t i = 0; i < centerPoints.size(); i++) {
-        glm::vec3 prev = centerPoints[(i - 1 + centerPoints.size()) % centerPoints.size()];
-        glm::vec3 current = centerPoints[i];
-        glm::vec3 next = centerPoints[(i + 1) % centerPoints.size()];
-        
-        glm::vec3 tangent = glm::normalize(next - prev);
-        tangents.push_back(tangent);
-        
-        glm::vec3 normal = glm::normalize(glm::cross(tangent, glm::vec3(0.0f, 1.0f, 0.0f)));
-        normals.push_back(normal);
+    // Cross-section normals in (lateral, height) space, averaged over the adjacent profile edges
+    const size_t profile_count = profile.size();
+    profile_normals.resize(profile_count);
+    for (size_t k = 0; k < profile_count; k++) {
+        const ProfileVertex& a = profile[k == 0 ? 0 : k - 1];
+        const ProfileVertex& b = profile[k + 1 == profile_count ? k : k + 1];
+        glm::vec2 edge(b.lateral - a.lateral, b.height - a.height);
+        profile_normals[k] = glm::normalize(glm::vec2(-edge.y, edge.x));
     }
 
-    for (size_t i = 0; i < centerPoints.size(); i++) {
-        innerPoints.push_back(centerPoints[i] - normals[i] * track_width * 0.5f);
-        outerPoints.push_back(centerPoints[i] + normals[i] * track_width * 0.5f);
+    const size_t ring_count = center_samples.size();
+    mesh->verts.resize(ring_count * profile_count);
+    mesh->mappings.resize(ring_count * profile_count);
+    mesh->normals.resize(ring_count * profile_count);
+
+    for (size_t i = 0; i < ring_count; i++) {
+        // The curve repeats its first sample at the end; reuse ring 0 there so the loop closes exactly
+        size_t source = (i + 1 == ring_count) ? 0 : i;
+        emit_ring(*mesh, i, source, static_cast<int>(profile_count));
     }
 
-    for (size_t i = 0; i < centerPoints.size(); i++) {
-        glm::vec3 surfaceNormal(0.0f, 1.0f, 0.0f);
-        
-        mesh->verts.push_back(innerPoints[i]);
-        mesh->mappings.push_back(glm::vec2(static_cast<float>(i) * textureScale, 0.0f));
-        mesh->normals.push_back(surfaceNormal);
-        
-        mesh->verts.push_back(outerPoints[i]);
-        mesh->mappings.push_back(glm::vec2(static_cast<float>(i) * textureScale, 1.0f));
-        mesh->normals.push_back(surfaceNormal);
-    }
-    //manually remove last vertices and replace with starting ones ???
-    mesh->verts.pop_back();
-    mesh->mappings.pop_back();
-    mesh->normals.pop_back();
-    mesh->verts.pop_back();
-    mesh->mappings.pop_back();
-    mesh->normals.pop_back();
-
-    mesh->verts.push_back(mesh->verts[0]);
-    mesh->mappings.push_back(mesh->mappings[0]);
-    mesh->normals.push_back(mesh->normals[0]);
-    mesh->verts.push_back(mesh->verts[1]);
-    mesh->mappings.push_back(mesh->mappings[1]);
-    mesh->normals.push_back(mesh->normals[1]);
-
-    mesh->groups[0]->VAO = 0;
-    mesh->groups[0]->VBO = 0;
-    mesh->groups[0]->vert_count = 0;
-    mesh->groups[0]->faces.clear();
-
-    int numSegments = centerPoints.size();
-    for (int i = 0; i < numSegments; i++) {
+    build_chunks(*mesh, static_cast<int>(ring_count), static_cast<int>(profile_count));
+
+    built_mesh = mesh;
+    built_profile = profile;
+    built_lod_levels = lod_levels;
+    built_chunk_length = chunk_length;
+    layout_dirty = false;
+    dirty_first = dirty_last = -1;
+    note_samples_changed(0, center_samples.size() - 1);
+    last_build_partial = false;
+
+    size_t triangles = 0;
+    for (const auto& group : mesh->groups) {
+        triangles += group->faces.size();
+    }
+    std::cout << "Generated track mesh: " << mesh->verts.size() << " vertices, " 
+              << triangles * 3 << " indices (" << triangles << " triangles), "
+              << chunks_rebuilt << "/" << chunk_starts.size() - 1 << " chunks rebuilt" << std::endl;
+}
+
+// Re-evaluates the dirty spline segments and rewrites the rings whose samples or
+// tangents changed. Frames are transported from the untouched ring before the
+// range; the twist they arrive with at the untouched ring after it is spread
+// back over the range, so the rest of the track keeps its vertices. Faces stay
+// as they are since the topology does not change.
+void TrackEditor::update_partial(Mesh& mesh) {
+    const int steps = center_spline.getStepsPerSegment();
+    const int P = static_cast<int>(profile.size());
+    const int numSegments = static_cast<int>(center_samples.size());
+
+    center_spline.evaluateSegments(dirty_first, dirty_last, center_samples);
+    attribute_spline.evaluateSegments(dirty_first, dirty_last, attribute_samples);
+
+    size_t lo = static_cast<size_t>(dirty_first * steps - 1);
+    size_t hi = static_cast<size_t>((dirty_last + 1) * steps);
+    note_samples_changed(lo + 1, hi - 1);
+    dirty_first = dirty_last = -1;
+
+    for (size_t i = lo; i <= hi; i++) {
+        frame_tangents[i] = frame_tangent(i);
+    }
+    for (size_t i = lo - 1; i < hi; i++) {
+        frame_bases[i + 1] = transport_frame(i, frame_bases[i]);
+    }
+    glm::vec3 arrived = transport_frame(hi, frame_bases[hi]);
+    const glm::vec3& t_exit = frame_tangents[hi + 1];
+    const glm::vec3& r_exit = frame_bases[hi + 1];
+    arrived -= t_exit * glm::dot(t_exit, arrived);
+    float twist = std::atan2(glm::dot(glm::cross(arrived, r_exit), t_exit), glm::dot(arrived, r_exit));
+
+    float span = static_cast<float>(hi - lo + 2);
+    for (size_t i = lo; i <= hi; i++) {
+        float roll = twist * static_cast<float>(i - lo + 1) / span;
+        if (roll != 0.0f) {
+            frame_bases[i] = glm::normalize(rotate_about(frame_bases[i], frame_tangents[i], roll));
+        }
+        frame_ups[i] = banked_up(i);
+        emit_ring(mesh, i, i, P);
+    }
+
+    // Every chunk holding a segment that uses one of the rewritten rings
+    int first_segment = static_cast<int>(lo) - 1;
+    int last_segment = static_cast<int>(hi);
+    size_t chunk = std::upper_bound(chunk_starts.begin(), chunk_starts.end(), first_segment) - chunk_starts.begin() - 1;
+    chunks_rebuilt = 0;
+    for (; chunk + 1 < chunk_starts.size() && chunk_starts[chunk] <= last_segment; chunk++) {
+        Group& group = *mesh.groups[chunk];
+        group.content_hash = chunk_hash(mesh, chunk, P, numSegments);
+        fill_chunk(mesh, group, chunk, P, numSegments, false);
+        group.dirty = true;
+        chunks_rebuilt++;
+    }
+}
+
+uint32_t TrackEditor::chunk_hash(const Mesh& mesh, size_t chunk, int P, int numSegments) const {
+    uint32_t hash = 2166136261u;
+    for (int ring = chunk_starts[chunk]; ring <= chunk_starts[chunk + 1]; ring++) {
+        size_t first = static_cast<size_t>(ring % numSegments) * P;
+        hash = fnv1a(&mesh.verts[first], P * sizeof(glm::vec3), hash);
+        hash = fnv1a(&mesh.mappings[first], P * sizeof(glm::vec2), hash);
+        hash = fnv1a(&mesh.normals[first], P * sizeof(glm::vec3), hash);
+    }
+    return hash;
+}
+
+// Bounds and LOD errors of one chunk, plus its faces when the layout changed
+void TrackEditor::fill_chunk(const Mesh& mesh, Group& group, size_t chunk, int P, int numSegments, bool write_faces) const {
+    int first_segment = chunk_starts[chunk];
+    int last_segment = chunk_starts[chunk + 1];
+    if (write_faces) {
+        resize_faces(group.faces, static_cast<size_t>(last_segment - first_segment) * (P - 1) * 2);
+    }
+
+    glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+    size_t f = 0;
+    for (int i = first_segment; i < last_segment; i++) {
         int next_i = (i + 1) % numSegments;
-        
-        int inner_current = i * 2;
-        int outer_current = i * 2 + 1;
-        int inner_next = next_i * 2;
-        int outer_next = next_i * 2 + 1;
-        
-        //inner_current -> inner_next -> outer_current
-        auto face1 = std::make_shared<Face>();
-        face1->verts = {inner_current, inner_next, outer_current};
-        face1->textures = {inner_current, inner_next, outer_current};
-        face1->normals = {inner_current, inner_next, outer_current};
-        mesh->groups[0]->faces.push_back(face1);
-        
-        //outer_current -> inner_next -> outer_next
-        auto face2 = std::make_shared<Face>();
-        face2->verts = {outer_current, inner_next, outer_next};
-        face2->textures = {outer_current, inner_next, outer_next};
-        face2->normals = {outer_current, inner_next, outer_next};
-        mesh->groups[0]->faces.push_back(face2);
+        if (write_faces) {
+            write_strip(group.faces, f, i, next_i, P);
+        }
+        for (int k = 0; k < P; k++) {
+            min = glm::min(min, mesh.verts[i * P + k]);
+            max = glm::max(max, mesh.verts[i * P + k]);
+            min = glm::min(min, mesh.verts[next_i * P + k]);
+            max = glm::max(max, mesh.verts[next_i * P + k]);
+        }
     }
 
-    mesh->process_data();
+    // Decimated levels skip rings inside the chunk but always keep its first and last
+    // ring, which are shared with the neighbouring chunks, so mixed levels never crack
+    if (write_faces) {
+        group.lods.resize(lod_levels > 1 ? lod_levels - 1 : 0);
+    }
+    for (size_t level = 0; level < group.lods.size(); level++) {
+        GroupLod& lod = group.lods[level];
+        int stride = 2 << level;
+        int segment_count = (last_segment - first_segment + stride - 1) / stride;
+        if (write_faces) {
+            resize_faces(lod.faces, static_cast<size_t>(segment_count) * (P - 1) * 2);
+        }
 
-    std::cout << "Generated track mesh: " << mesh->verts.size() << " vertices, " 
-              << mesh->groups[0]->faces.size() * 3 << " indices (" 
-              << mesh->groups[0]->faces.size() << " triangles)" << std::endl;
+        size_t lf = 0;
+        float error = 0.0f;
+        for (int i = first_segment; i < last_segment; i += stride) {
+            int j = std::min(i + stride, last_segment);
+            if (write_faces) {
+                write_strip(lod.faces, lf, i, j % numSegments, P);
+            }
+            for (int skipped = i + 1; skipped < j; skipped++) {
+                float t = static_cast<float>(skipped - i) / static_cast<float>(j - i);
+                for (int k = 0; k < P; k++) {
+                    glm::vec3 approx = glm::mix(mesh.verts[i * P + k], mesh.verts[(j % numSegments) * P + k], t);
+                    error = std::max(error, glm::distance(approx, mesh.verts[skipped * P + k]));
+                }
+            }
+        }
+        lod.error = error;
+    }
+    group.bounds.min = min;
+    group.bounds.max = max;
+    group.bounds.center = (min + max) * 0.5f;
+    group.bounds.size = max - min;
+    group.bounds.halfSize = group.bounds.size * 0.5f;
 }
 
-void TrackEditor::export_track_OBJ(const std::string& filename) {
+void TrackEditor::build_chunks(Mesh& mesh, int ring_count, int profile_count) {
+    const int P = profile_count;
+    const int numSegments = ring_count;
+
+    // Consecutive segments whose midpoint falls in the same tile form one chunk
+    chunk_starts.clear();
+    glm::ivec2 current_tile(0);
+    for (int i = 0; i < numSegments; i++) {
+        glm::vec3 mid = (center_samples[i] + center_samples[(i + 1) % numSegments]) * 0.5f;
+        glm::ivec2 tile(static_cast<int>(std::floor(mid.x / chunk_length)),
+                        static_cast<int>(std::floor(mid.z / chunk_length)));
+        if (i == 0 || tile != current_tile) {
+            chunk_starts.push_back(i);
+            current_tile = tile;
+        }
+    }
+    chunk_starts.push_back(numSegments);
+
+    // Previous groups are looked up by the hash of their geometry so unchanged chunks keep their buffers
+    groups_by_hash.clear();
+    for (size_t g = 0; g < mesh.groups.size(); g++) {
+        if (mesh.groups[g]->has_bounds) {
+            groups_by_hash.emplace(mesh.groups[g]->content_hash, g);
+        }
+    }
+    std::vector<char>& claimed = group_claimed;
+    claimed.assign(mesh.groups.size(), 0);
+
+    size_t chunk_count = chunk_starts.size() - 1;
+    chunk_groups.assign(chunk_count, nullptr);
+    chunk_hashes.resize(chunk_count);
+    chunks_rebuilt = 0;
+
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+        uint32_t hash = chunk_hash(mesh, chunk, P, numSegments);
+        chunk_hashes[chunk] = hash;
+
+        auto found = groups_by_hash.find(hash);
+        if (found != groups_by_hash.end() && !claimed[found->second]) {
+            claimed[found->second] = 1;
+            chunk_groups[chunk] = mesh.groups[found->second];
+        }
+    }
+
+    // Changed chunks take over the buffers of groups that were not matched
+    size_t spare = 0;
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+        if (chunk_groups[chunk]) {
+            chunk_groups[chunk]->dirty = false;
+            continue;
+        }
+        while (spare < mesh.groups.size() && claimed[spare]) spare++;
+        if (spare < mesh.groups.size()) {
+            claimed[spare] = 1;
+            chunk_groups[chunk] = mesh.groups[spare];
+        } else {
+            chunk_groups[chunk] = std::make_shared<Group>("track_chunk");
+        }
+        chunk_groups[chunk]->dirty = true;
+        chunks_rebuilt++;
+    }
+
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+        auto& group = chunk_groups[chunk];
+        group->material = material;
+        group->content_hash = chunk_hashes[chunk];
+        group->has_bounds = true;
+        fill_chunk(mesh, *group, chunk, P, numSegments, true);
+    }
+
+    // Unmatched groups stay at the end, empty, so their buffers can be reused by later edits
+    for (size_t g = 0; g < mesh.groups.size(); g++) {
+        if (claimed[g]) continue;
+        auto& group = mesh.groups[g];
+        group->faces.clear();
+        group->lods.clear();
+        group->has_bounds = false;
+        group->dirty = true;
+        chunk_groups.push_back(group);
+    }
+    mesh.groups.swap(chunk_groups);
+
+    mesh.process_data();
+}
+
+size_t TrackEditor::export_track_OBJ(const std::string& filename) {
     auto mesh = std::make_shared<Mesh>();
     generate_track_mesh(mesh);
     
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << std::endl;
-        return;
-    }
+    BufferedWriter file;
+    file.reserve(mesh->verts.size() * 96 + 256);
     
     file << "# Racetrack exported from editor\n";
     file << "# Vertices: " << mesh->verts.size() << "\n\n";
@@ -170,49 +640,54 @@ void TrackEditor::export_track_OBJ(const std::string& filename) {
     file << "mtllib exported_track.mtl\n";
     file << "o track\n";
     for (const auto& vertex : mesh->verts) {
-        file << "v " << vertex.x << " " << vertex.y << " " << vertex.z << "\n";
+        file << "v " << vertex.x << ' ' << vertex.y << ' ' << vertex.z << '\n';
     }
     
     for (const auto& uv : mesh->mappings) {
-        file << "vt " << uv.x << " " << uv.y << "\n";
+        file << "vt " << uv.x << ' ' << uv.y << '\n';
     }
     
     for (const auto& normal : mesh->normals) {
-        file << "vn " << normal.x << " " << normal.y << " " << normal.z << "\n";
+        file << "vn " << normal.x << ' ' << normal.y << ' ' << normal.z << '\n';
     }
     
-    if (!mesh->groups.empty() && !mesh->groups[0]->faces.empty()) {
+    if (!mesh->groups.empty()) {
         file << "\nusemtl TrackMaterial\n";
         file << "s 1\n";
         
-        for (const auto& face : mesh->groups[0]->faces) {
-            file << "f";
-            for (size_t j = 0; j < face->verts.size(); j++) {
-                file << " " << (face->verts[j] + 1) << "/" 
-                     << (face->textures[j] + 1) << "/" 
-                     << (face->normals[j] + 1);
+        for (const auto& group : mesh->groups) {
+            for (const auto& face : group->faces) {
+                file << 'f';
+                for (size_t j = 0; j < face->verts.size(); j++) {
+                    file << ' ' << (face->verts[j] + 1) << '/' 
+                         << (face->textures[j] + 1) << '/' 
+                         << (face->normals[j] + 1);
+                }
+                file << '\n';
             }
-            file << "\n";
         }
     }
     
-    file.close();
+    if (!file.write_to_file(filename)) {
+        return 0;
+    }
     std::cout << "Exported track to " << filename << std::endl;
+    return file.size();
 }
 
-void TrackEditor::export_animation_file(const std::string& filename) {
+size_t TrackEditor::export_animation_file(const std::string& filename) {
     auto centerPoints = center_spline.evaluateCurve();
     
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << std::endl;
-        return;
-    }
+    BufferedWriter file;
+    file.reserve(centerPoints.size() * 40 + 64);
     
     file << "# Animation points for racetrack\n";
     for (const auto& point : centerPoints) {
-        file << point.x << " " << point.z << " " << -point.y << "\n";
+        file << point.x << ' ' << point.z << ' ' << point.y << '\n';
     }
     
-    file.close();
-}
\ No newline at end of file
+    if (!file.write_to_file(filename)) {
+        return 0;
+    }
+    return file.size();
+}
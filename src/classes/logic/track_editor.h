@@ -3,25 +3,113 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <string>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include "track_profile.h"
+#include "point_grid.h"
 #include "../rendering/2D/bcurve.h"
 #include "../rendering/3D/mesh.h"
 
 class TrackEditor {
 public:
     std::vector<glm::vec2> control_points;
+    std::vector<TrackPointAttributes> point_attributes;
+    std::vector<ProfileVertex> profile = TrackProfile::flat();
     BSpline center_spline;
+    BSpline attribute_spline;
     float track_width;
+    float chunk_length = 50.0f;
+    int lod_levels = 3;     // full detail plus decimated levels at every 2nd, 4th, ... ring
     bool is_editing;
     std::shared_ptr<Material> material;
+    PointGrid point_index;  // control_points by elevation and position, kept in sync by every edit
 
     TrackEditor(float width = 1.0f) : track_width(width), is_editing(true) {}
 
     void add_control_point(const glm::vec2& point);
     void pop_back_control_points();
     void clear_control_points();
+    void set_control_points(const std::vector<glm::vec2>& points);
+    void set_point_attributes(size_t index, const TrackPointAttributes& attributes);
+    void move_control_point(size_t index, const glm::vec2& point);
+    void insert_control_point(size_t index, const glm::vec2& point);
+    void remove_control_point(size_t index);
+
+    // Closest control point at the given elevation within radius, or -1
+    int nearest_control_point(const glm::vec2& point, float radius, float elevation) const;
+    // Distinct elevations of the control points, ascending
+    const std::vector<float>& elevation_levels() const { return point_index.levels(); }
+    // Index a point placed within radius of the last generated centerline should be
+    // inserted at to split the segment under it, or -1
+    int nearest_segment(const glm::vec2& point, float radius) const;
+
+    // Moves and attribute edits only touch the spline segments they influence, so
+    // generate_track_mesh re-evaluates those and rewrites the vertices of the affected
+    // chunks in place. Chunk boundaries are kept until the next full rebuild, which
+    // this forces.
+    void invalidate_layout() { layout_dirty = true; }
+
+    // Bumped on every change to the points or the sampled centerline, so mirrors
+    // such as the editor overlay can skip frames where nothing happened
+    uint64_t revision = 0;
+    // Ranges changed since the previous call (points edited/appended, centerline samples
+    // rewritten); false when there is nothing to refresh
+    bool take_point_changes(size_t& first, size_t& last);
+    bool take_sample_changes(size_t& first, size_t& last);
+    // Samples of the last generated centerline (empty or stale below 4 control points)
+    const std::vector<glm::vec3>& curve_samples() const { return center_samples; }
     
+    // Builds the ribbon as one Group per chunk_length x chunk_length tile run.
+    // Chunks whose geometry did not change keep their Group (and GL buffers) untouched.
     void generate_track_mesh(std::shared_ptr<Mesh>);
+    size_t chunks_rebuilt = 0;
+    bool last_build_partial = false;
     
-    void export_track_OBJ(const std::string& filename);
-    void export_animation_file(const std::string& filename);
-};
\ No newline at end of file
+    size_t export_track_OBJ(const std::string& filename);
+    size_t export_animation_file(const std::string& filename);
+
+private:
+    // Scratch buffers reused between generate_track_mesh calls
+    std::vector<glm::vec3> center_samples;
+    std::vector<glm::vec3> attribute_samples;
+    std::vector<glm::vec3> frame_tangents;
+    std::vector<glm::vec3> frame_bases;     // rotation-minimising up vectors before banking
+    std::vector<glm::vec3> frame_ups;
+    std::vector<glm::vec2> profile_normals;
+    std::vector<int> chunk_starts;
+    std::vector<std::shared_ptr<Group>> chunk_groups;
+    std::vector<uint32_t> chunk_hashes;
+    std::vector<char> group_claimed;
+    std::unordered_map<uint32_t, size_t> groups_by_hash;
+
+    // What the last full rebuild was made from; partial updates are only valid against it
+    std::weak_ptr<Mesh> built_mesh;
+    std::vector<ProfileVertex> built_profile;
+    int built_lod_levels = 0;
+    float built_chunk_length = 0.0f;
+    bool layout_dirty = true;
+    int dirty_first = -1;   // range of spline segments touched since the last build
+    int dirty_last = -1;
+    size_t points_changed_first = SIZE_MAX;
+    size_t points_changed_last = 0;
+    size_t samples_changed_first = SIZE_MAX;
+    size_t samples_changed_last = 0;
+
+    void sync_spline();
+    void sync_spline_point(size_t index);
+    void mark_point_dirty(size_t index);
+    void note_points_changed(size_t first, size_t last);
+    void note_samples_changed(size_t first, size_t last);
+    bool can_update_partial(const std::shared_ptr<Mesh>& mesh) const;
+    void update_partial(Mesh& mesh);
+
+    glm::vec3 frame_tangent(size_t i) const;
+    glm::vec3 transport_frame(size_t i, const glm::vec3& up) const;
+    glm::vec3 banked_up(size_t i) const;
+    void compute_frames();
+    void emit_ring(Mesh& mesh, size_t ring, size_t source, int profile_count) const;
+    uint32_t chunk_hash(const Mesh& mesh, size_t chunk, int profile_count, int numSegments) const;
+    void fill_chunk(const Mesh& mesh, Group& group, size_t chunk, int profile_count, int numSegments, bool write_faces) const;
+    void build_chunks(Mesh& mesh, int ring_count, int profile_count);
+};
@@ -0,0 +1,78 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#include "track_document.h"
+#include "track_exporter.h"
+
+bool TrackExporter::start(const TrackEditor& editor, const std::string& obj_file, const std::string& animation_file,
+                          const std::string& document_file) {
+    if (busy()) {
+        std::cout << "Export already in progress" << std::endl;
+        return false;
+    }
+    if (editor.control_points.size() < 4) {
+        std::cout << "Need at least 4 control points for track generation" << std::endl;
+        return false;
+    }
+
+    auto snapshot = std::make_shared<TrackEditor>(editor);
+    pending = std::async(std::launch::async, [snapshot, obj_file, animation_file, document_file]() {
+        TrackExportResult result;
+        result.obj_file = obj_file;
+        result.animation_file = animation_file;
+        result.document_file = document_file;
+
+        auto begin = std::chrono::steady_clock::now();
+        size_t obj_bytes = snapshot->export_track_OBJ(obj_file);
+        size_t animation_bytes = snapshot->export_animation_file(animation_file);
+        if (!document_file.empty() && !TrackDocument::save(document_file, *snapshot)) {
+            obj_bytes = 0;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        result.success = obj_bytes > 0 && animation_bytes > 0;
+        result.bytes_written = obj_bytes + animation_bytes;
+        result.milliseconds = std::chrono::duration<double, std::milli>(end - begin).count();
+        return result;
+    });
+    return true;
+}
+
+bool TrackExporter::save(const TrackEditor& editor, const std::string& document_file) {
+    if (busy()) {
+        std::cout << "Export already in progress" << std::endl;
+        return false;
+    }
+
+    auto snapshot = std::make_shared<TrackEditor>(editor);
+    pending = std::async(std::launch::async, [snapshot, document_file]() {
+        TrackExportResult result;
+        result.document_file = document_file;
+
+        auto begin = std::chrono::steady_clock::now();
+        result.success = TrackDocument::save(document_file, *snapshot);
+        auto end = std::chrono::steady_clock::now();
+        result.milliseconds = std::chrono::duration<double, std::milli>(end - begin).count();
+        return result;
+    });
+    return true;
+}
+
+bool TrackExporter::busy() const {
+    return pending.valid();
+}
+
+bool TrackExporter::poll(TrackExportResult& result) {
+    if (!pending.valid()) return false;
+    if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+
+    result = pending.get();
+    return true;
+}
+
+void TrackExporter::wait() {
+    if (pending.valid()) {
+        pending.wait();
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <future>
+#include <string>
+
+#include "track_editor.h"
+
+struct TrackExportResult {
+    bool success = false;
+    std::string obj_file;
+    std::string animation_file;
+    std::string document_file;
+    size_t bytes_written = 0;
+    double milliseconds = 0.0;
+};
+
+// Runs export_track_OBJ/export_animation_file and TrackDocument::save on a
+// worker thread against a snapshot of the editor, so the input callback
+// returns immediately. One job runs at a time.
+class TrackExporter {
+public:
+    bool start(const TrackEditor& editor, const std::string& obj_file, const std::string& animation_file,
+               const std::string& document_file = "");
+    // Writes only the track document (Ctrl+S); shares the worker so saves and exports never overlap
+    bool save(const TrackEditor& editor, const std::string& document_file);
+    bool busy() const;
+    bool poll(TrackExportResult& result);
+    void wait();
+
+private:
+    std::future<TrackExportResult> pending;
+};
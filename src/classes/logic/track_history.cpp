@@ -0,0 +1,244 @@
+#include <algorithm>
+
+#include "track_history.h"
+
+namespace {
+
+TrackCommand make_command(TrackCommand::Type type, size_t index) {
+    TrackCommand command = {};
+    command.type = type;
+    command.index = static_cast<uint32_t>(index);
+    return command;
+}
+
+// Memory a snapshot of this many points takes; tiny tracks still get a reasonable interval
+size_t snapshot_bytes(size_t points) {
+    return std::max(points * (sizeof(glm::vec2) + sizeof(TrackPointAttributes)), 64 * sizeof(TrackCommand));
+}
+
+}
+
+// Drops the redo branch and makes sure there is a snapshot to seek from
+void TrackHistory::begin_record(const TrackEditor& editor) {
+    if (cursor < commands.size()) {
+        commands.resize(cursor);
+        while (!snapshots.empty() && snapshots.back().position > cursor) {
+            snapshots.pop_back();
+        }
+    }
+    if (snapshots.empty()) {
+        take_snapshot(editor);
+    }
+}
+
+void TrackHistory::record(const TrackEditor& editor, const TrackCommand& command) {
+    commands.push_back(command);
+    cursor = commands.size();
+
+    bytes_since_snapshot += sizeof(TrackCommand);
+    if (bytes_since_snapshot >= snapshot_bytes(editor.control_points.size())) {
+        take_snapshot(editor);
+    }
+}
+
+uint32_t TrackHistory::take_snapshot(const TrackEditor& editor) {
+    if (!snapshots.empty() && snapshots.back().position == cursor) {
+        return static_cast<uint32_t>(snapshots.size() - 1);
+    }
+    TrackSnapshot snapshot;
+    snapshot.position = cursor;
+    snapshot.control_points = editor.control_points;
+    snapshot.point_attributes = editor.point_attributes;
+    snapshots.push_back(std::move(snapshot));
+    bytes_since_snapshot = 0;
+    return static_cast<uint32_t>(snapshots.size() - 1);
+}
+
+void TrackHistory::restore(TrackEditor& editor, const TrackSnapshot& snapshot) const {
+    editor.point_attributes = snapshot.point_attributes;
+    editor.set_control_points(snapshot.control_points);
+}
+
+void TrackHistory::add_point(TrackEditor& editor, const glm::vec2& point) {
+    begin_record(editor);
+    TrackCommand command = make_command(TrackCommand::ADD, editor.control_points.size());
+    command.after = point;
+    editor.add_control_point(point);
+    command.attributes_after = editor.point_attributes.back();
+    record(editor, command);
+}
+
+void TrackHistory::pop_point(TrackEditor& editor) {
+    if (editor.control_points.empty()) return;
+    begin_record(editor);
+    TrackCommand command = make_command(TrackCommand::POP, editor.control_points.size() - 1);
+    command.before = editor.control_points.back();
+    command.attributes_before = editor.point_attributes.back();
+    editor.pop_back_control_points();
+    record(editor, command);
+}
+
+void TrackHistory::move_point(TrackEditor& editor, size_t index, const glm::vec2& point) {
+    if (index >= editor.control_points.size()) return;
+    if (merging && cursor > merge_from && cursor == commands.size()) {
+        TrackCommand& last = commands[cursor - 1];
+        if (last.type == TrackCommand::MOVE && last.index == index) {
+            last.after = point;
+            editor.move_control_point(index, point);
+            if (snapshots.back().position == cursor) {
+                snapshots.back().control_points[index] = point;
+            }
+            return;
+        }
+    }
+    begin_record(editor);
+    TrackCommand command = make_command(TrackCommand::MOVE, index);
+    command.before = editor.control_points[index];
+    command.after = point;
+    editor.move_control_point(index, point);
+    record(editor, command);
+}
+
+void TrackHistory::insert_point(TrackEditor& editor, size_t index, const glm::vec2& point) {
+    if (index > editor.control_points.size()) return;
+    begin_record(editor);
+    TrackCommand command = make_command(TrackCommand::INSERT, index);
+    command.after = point;
+    editor.insert_control_point(index, point);
+    command.attributes_after = editor.point_attributes[index];
+    record(editor, command);
+}
+
+void TrackHistory::remove_point(TrackEditor& editor, size_t index) {
+    if (index >= editor.control_points.size()) return;
+    begin_record(editor);
+    TrackCommand command = make_command(TrackCommand::REMOVE, index);
+    command.before = editor.control_points[index];
+    command.attributes_before = editor.point_attributes[index];
+    editor.remove_control_point(index);
+    record(editor, command);
+}
+
+void TrackHistory::set_attributes(TrackEditor& editor, size_t index, const TrackPointAttributes& attributes) {
+    if (index >= editor.point_attributes.size()) return;
+    if (merging && cursor > merge_from && cursor == commands.size()) {
+        TrackCommand& last = commands[cursor - 1];
+        if (last.type == TrackCommand::SET_ATTRIBUTES && last.index == index) {
+            last.attributes_after = attributes;
+            editor.set_point_attributes(index, attributes);
+            if (snapshots.back().position == cursor) {
+                snapshots.back().point_attributes[index] = attributes;
+            }
+            return;
+        }
+    }
+    begin_record(editor);
+    TrackCommand command = make_command(TrackCommand::SET_ATTRIBUTES, index);
+    command.attributes_before = editor.point_attributes[index];
+    command.attributes_after = attributes;
+    editor.set_point_attributes(index, attributes);
+    record(editor, command);
+}
+
+void TrackHistory::clear(TrackEditor& editor) {
+    if (editor.control_points.empty()) return;
+    begin_record(editor);
+    TrackCommand command = make_command(TrackCommand::CLEAR, 0);
+    command.snapshot = take_snapshot(editor);
+    editor.clear_control_points();
+    record(editor, command);
+}
+
+void TrackHistory::apply(TrackEditor& editor, const TrackCommand& command, bool forward) const {
+    switch (command.type) {
+    case TrackCommand::ADD:
+    case TrackCommand::POP: {
+        bool adding = (command.type == TrackCommand::ADD) == forward;
+        if (adding) {
+            bool add = command.type == TrackCommand::ADD;
+            editor.add_control_point(add ? command.after : command.before);
+            editor.set_point_attributes(command.index, add ? command.attributes_after : command.attributes_before);
+        } else {
+            editor.pop_back_control_points();
+        }
+        break;
+    }
+    case TrackCommand::INSERT:
+    case TrackCommand::REMOVE: {
+        bool inserting = (command.type == TrackCommand::INSERT) == forward;
+        if (inserting) {
+            bool insert = command.type == TrackCommand::INSERT;
+            editor.insert_control_point(command.index, insert ? command.after : command.before);
+            editor.set_point_attributes(command.index, insert ? command.attributes_after : command.attributes_before);
+        } else {
+            editor.remove_control_point(command.index);
+        }
+        break;
+    }
+    case TrackCommand::MOVE:
+        editor.move_control_point(command.index, forward ? command.after : command.before);
+        break;
+    case TrackCommand::SET_ATTRIBUTES:
+        editor.set_point_attributes(command.index, forward ? command.attributes_after : command.attributes_before);
+        break;
+    case TrackCommand::CLEAR:
+        if (forward) {
+            editor.clear_control_points();
+        } else {
+            restore(editor, snapshots[command.snapshot]);
+        }
+        break;
+    }
+}
+
+bool TrackHistory::undo(TrackEditor& editor) {
+    if (!can_undo()) return false;
+    merging = false;
+    cursor--;
+    apply(editor, commands[cursor], false);
+    return true;
+}
+
+bool TrackHistory::redo(TrackEditor& editor) {
+    if (!can_redo()) return false;
+    merging = false;
+    apply(editor, commands[cursor], true);
+    cursor++;
+    return true;
+}
+
+bool TrackHistory::seek(TrackEditor& editor, size_t position) {
+    if (position > commands.size()) return false;
+
+    // Last snapshot at or before the target
+    auto it = std::upper_bound(snapshots.begin(), snapshots.end(), position,
+        [](size_t p, const TrackSnapshot& s) { return p < s.position; });
+    if (it != snapshots.begin()) {
+        const TrackSnapshot& snapshot = *(it - 1);
+        size_t stepping = position > cursor ? position - cursor : cursor - position;
+        if (position - snapshot.position < stepping) {
+            restore(editor, snapshot);
+            cursor = snapshot.position;
+        }
+    }
+    while (cursor > position) undo(editor);
+    while (cursor < position) redo(editor);
+    return true;
+}
+
+void TrackHistory::reset() {
+    commands.clear();
+    snapshots.clear();
+    cursor = 0;
+    merging = false;
+    bytes_since_snapshot = 0;
+}
+
+size_t TrackHistory::memory_bytes() const {
+    size_t bytes = commands.capacity() * sizeof(TrackCommand) + snapshots.capacity() * sizeof(TrackSnapshot);
+    for (const auto& snapshot : snapshots) {
+        bytes += snapshot.control_points.capacity() * sizeof(glm::vec2);
+        bytes += snapshot.point_attributes.capacity() * sizeof(TrackPointAttributes);
+    }
+    return bytes;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "track_editor.h"
+
+// One reversible track edit. Every command has the same fixed size; edits that
+// discard an unbounded amount of data (clear) refer to a snapshot instead.
+struct TrackCommand {
+    enum Type : uint8_t { ADD, POP, MOVE, INSERT, REMOVE, SET_ATTRIBUTES, CLEAR };
+
+    Type type;
+    uint32_t index;
+    uint32_t snapshot;      // CLEAR: snapshot of the points that were cleared
+    glm::vec2 before;
+    glm::vec2 after;
+    TrackPointAttributes attributes_before;
+    TrackPointAttributes attributes_after;
+};
+
+// Full copy of the editable track state after the first `position` commands
+struct TrackSnapshot {
+    size_t position;
+    std::vector<glm::vec2> control_points;
+    std::vector<TrackPointAttributes> point_attributes;
+};
+
+// Undo/redo journal for track edits. Edits go through the history, which applies
+// them to the editor and records them; undo and redo replay the inverse or the
+// original through the editor's incremental API, so moving a point back only
+// rebuilds the part of the track it touched.
+//
+// A snapshot is taken whenever the commands recorded since the last one take up
+// as much memory as a snapshot would, which keeps snapshots to at most about the
+// size of the log while bounding how far seek() has to replay.
+class TrackHistory {
+public:
+    void add_point(TrackEditor& editor, const glm::vec2& point);
+    void pop_point(TrackEditor& editor);
+    void move_point(TrackEditor& editor, size_t index, const glm::vec2& point);
+    void insert_point(TrackEditor& editor, size_t index, const glm::vec2& point);
+    void remove_point(TrackEditor& editor, size_t index);
+    void set_attributes(TrackEditor& editor, size_t index, const TrackPointAttributes& attributes);
+    void clear(TrackEditor& editor);
+
+    // Between begin_merge and end_merge, repeated moves or attribute changes of the
+    // same point collapse into a single step (one drag = one undo)
+    void begin_merge() { merging = true; merge_from = cursor; }
+    void end_merge() { merging = false; }
+
+    bool undo(TrackEditor& editor);
+    bool redo(TrackEditor& editor);
+    bool can_undo() const { return cursor > 0; }
+    bool can_redo() const { return cursor < commands.size(); }
+
+    // Brings the editor to the state after the first `position` commands, starting
+    // from the closest snapshot when that is shorter than stepping from the cursor
+    bool seek(TrackEditor& editor, size_t position);
+
+    // Forgets all history; the current editor state becomes the new starting point
+    void reset();
+
+    size_t position() const { return cursor; }
+    size_t size() const { return commands.size(); }
+    size_t memory_bytes() const;
+
+private:
+    std::vector<TrackCommand> commands;
+    std::vector<TrackSnapshot> snapshots;
+    size_t cursor = 0;              // commands [0, cursor) are applied
+    bool merging = false;
+    size_t merge_from = 0;          // only commands recorded after begin_merge are merged into
+    size_t bytes_since_snapshot = 0;
+
+    void begin_record(const TrackEditor& editor);
+    void record(const TrackEditor& editor, const TrackCommand& command);
+    uint32_t take_snapshot(const TrackEditor& editor);
+    void restore(TrackEditor& editor, const TrackSnapshot& snapshot) const;
+    void apply(TrackEditor& editor, const TrackCommand& command, bool forward) const;
+};
@@ -0,0 +1,35 @@
+#include "track_profile.h"
+
+std::vector<ProfileVertex> TrackProfile::flat() {
+    return {
+        {-1.0f, 0.0f, 0.0f},
+        { 1.0f, 0.0f, 1.0f},
+    };
+}
+
+std::vector<ProfileVertex> TrackProfile::kerbs() {
+    return {
+        {-1.2f, 0.0f,  0.0f},
+        {-1.1f, 0.04f, 0.05f},
+        {-1.0f, 0.0f,  0.1f},
+        { 1.0f, 0.0f,  0.9f},
+        { 1.1f, 0.04f, 0.95f},
+        { 1.2f, 0.0f,  1.0f},
+    };
+}
+
+// Kerbs, gravel shoulders and a low wall on both sides
+std::vector<ProfileVertex> TrackProfile::circuit() {
+    return {
+        {-1.6f, 0.5f,  0.0f},
+        {-1.6f, 0.0f,  0.05f},
+        {-1.3f, 0.0f,  0.12f},
+        {-1.1f, 0.04f, 0.18f},
+        {-1.0f, 0.0f,  0.2f},
+        { 1.0f, 0.0f,  0.8f},
+        { 1.1f, 0.04f, 0.82f},
+        { 1.3f, 0.0f,  0.88f},
+        { 1.6f, 0.0f,  0.95f},
+        { 1.6f, 0.5f,  1.0f},
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+
+// Per control point track shape, interpolated along the spline.
+struct TrackPointAttributes {
+    float width = 1.0f;
+    float bank = 0.0f;          // radians, rolls the cross-section around the direction of travel
+    float elevation = 0.0f;     // world units above y = 0
+};
+
+// One vertex of the track cross-section, listed from the left edge to the right.
+// lateral is measured in half track widths from the centerline (-1/1 are the
+// road edges), height in world units above the road surface and v is the
+// texture coordinate across the track.
+struct ProfileVertex {
+    float lateral;
+    float height;
+    float v;
+};
+
+class TrackProfile {
+public:
+    static std::vector<ProfileVertex> flat();
+    static std::vector<ProfileVertex> kerbs();
+    static std::vector<ProfileVertex> circuit();
+};
@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <thread>
+
+#include "transform_hierarchy.h"
+
+namespace {
+// Below this many nodes per thread a depth level is cheaper to do on the calling thread
+const size_t MIN_NODES_PER_THREAD = 4096;
+// Updates with fewer than one dirty node in this many walk the dirty subtrees only
+const size_t SPARSE_RATIO = 16;
+}
+
+const uint32_t TransformHierarchy::NONE;
+
+uint32_t TransformHierarchy::add_node(const glm::mat4& local, uint32_t parent) {
+    if (!contains(parent)) parent = NONE;
+    uint32_t node;
+    if (!free_nodes.empty()) {
+        node = free_nodes.back();
+        free_nodes.pop_back();
+    } else {
+        node = (uint32_t)alive.size();
+        locals.emplace_back(1.0f);
+        worlds.emplace_back(1.0f);
+        parents.push_back(NONE);
+        changed.push_back(0);
+        dirty.push_back(0);
+        alive.push_back(0);
+        first_child.push_back(NONE);
+        next_sibling.push_back(NONE);
+        prev_sibling.push_back(NONE);
+    }
+    locals[node] = local;
+    worlds[node] = parent == NONE ? local : current_world(parent) * local;
+    link(node, parent);
+    changed[node] = 0;
+    alive[node] = 1;
+    mark_dirty(node);
+    order_valid = false;
+    return node;
+}
+
+void TransformHierarchy::remove_node(uint32_t node) {
+    if (!contains(node)) return;
+    for (uint32_t child = first_child[node]; child != NONE;) {
+        uint32_t next = next_sibling[child];
+        locals[child] = current_world(child);
+        parents[child] = NONE;
+        next_sibling[child] = prev_sibling[child] = NONE;
+        mark_dirty(child);
+        child = next;
+    }
+    first_child[node] = NONE;
+    if (dirty[node]) {
+        dirty[node] = 0;
+        dirty_count--;
+    }
+    unlink(node);
+    alive[node] = 0;
+    changed[node] = 0;
+    free_nodes.push_back(node);
+    order_valid = false;
+}
+
+bool TransformHierarchy::set_parent(uint32_t node, uint32_t parent) {
+    if (!contains(node)) return false;
+    if (!contains(parent)) parent = NONE;
+    for (uint32_t ancestor = parent; ancestor != NONE; ancestor = parents[ancestor]) {
+        if (ancestor == node) return false;
+    }
+    glm::mat4 world = current_world(node);
+    unlink(node);
+    link(node, parent);
+    locals[node] = parent == NONE ? world : glm::inverse(current_world(parent)) * world;
+    mark_dirty(node);
+    order_valid = false;
+    return true;
+}
+
+void TransformHierarchy::set_local(uint32_t node, const glm::mat4& local) {
+    if (!contains(node)) return;
+    locals[node] = local;
+    mark_dirty(node);
+}
+
+void TransformHierarchy::set_world(uint32_t node, const glm::mat4& world) {
+    if (!contains(node)) return;
+    uint32_t parent = parents[node];
+    locals[node] = parent == NONE ? world : glm::inverse(current_world(parent)) * world;
+    mark_dirty(node);
+}
+
+glm::mat4 TransformHierarchy::current_world(uint32_t node) const {
+    if (dirty_count == 0) return worlds[node];
+
+    // worlds[] is stale below the highest dirty ancestor; rebuild the chain from there
+    uint32_t top = NONE;
+    for (uint32_t n = node; n != NONE; n = parents[n]) {
+        if (dirty[n]) top = n;
+    }
+    if (top == NONE) return worlds[node];
+
+    std::vector<uint32_t> chain;
+    for (uint32_t n = node; n != top; n = parents[n]) {
+        chain.push_back(n);
+    }
+    glm::mat4 world = parents[top] == NONE ? locals[top] : worlds[parents[top]] * locals[top];
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        world = world * locals[*it];
+    }
+    return world;
+}
+
+void TransformHierarchy::clear() {
+    locals.clear();
+    worlds.clear();
+    parents.clear();
+    changed.clear();
+    dirty.clear();
+    alive.clear();
+    free_nodes.clear();
+    first_child.clear();
+    next_sibling.clear();
+    prev_sibling.clear();
+    order.clear();
+    level_offsets.clear();
+    preorder.clear();
+    subtree_end.clear();
+    preorder_positions.clear();
+    dirty_nodes.clear();
+    changed_nodes.clear();
+    order_valid = true;
+    dirty_count = 0;
+}
+
+void TransformHierarchy::mark_dirty(uint32_t node) {
+    if (!dirty[node]) {
+        dirty[node] = 1;
+        dirty_nodes.push_back(node);
+        dirty_count++;
+    }
+}
+
+void TransformHierarchy::link(uint32_t node, uint32_t parent) {
+    parents[node] = parent;
+    prev_sibling[node] = NONE;
+    next_sibling[node] = NONE;
+    if (parent == NONE) return;
+    next_sibling[node] = first_child[parent];
+    if (first_child[parent] != NONE) prev_sibling[first_child[parent]] = node;
+    first_child[parent] = node;
+}
+
+void TransformHierarchy::unlink(uint32_t node) {
+    uint32_t parent = parents[node];
+    if (parent != NONE) {
+        if (prev_sibling[node] != NONE) {
+            next_sibling[prev_sibling[node]] = next_sibling[node];
+        } else {
+            first_child[parent] = next_sibling[node];
+        }
+        if (next_sibling[node] != NONE) prev_sibling[next_sibling[node]] = prev_sibling[node];
+    }
+    parents[node] = NONE;
+    prev_sibling[node] = NONE;
+    next_sibling[node] = NONE;
+}
+
+void TransformHierarchy::rebuild_order() {
+    // Depth of every live node, following each chain up to the first known depth
+    std::vector<uint32_t> depths(alive.size(), NONE);
+    std::vector<uint32_t> chain;
+    size_t max_depth = 0;
+    for (uint32_t node = 0; node < alive.size(); node++) {
+        if (!alive[node]) continue;
+        uint32_t n = node;
+        while (n != NONE && depths[n] == NONE) {
+            chain.push_back(n);
+            n = parents[n];
+        }
+        uint32_t depth = n == NONE ? 0 : depths[n] + 1;
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            depths[*it] = depth++;
+        }
+        chain.clear();
+        max_depth = std::max<size_t>(max_depth, depths[node]);
+    }
+
+    // Counting sort by depth keeps ids ascending within a level
+    level_offsets.assign(max_depth + 2, 0);
+    for (uint32_t node = 0; node < alive.size(); node++) {
+        if (alive[node]) level_offsets[depths[node] + 1]++;
+    }
+    for (size_t d = 1; d < level_offsets.size(); d++) {
+        level_offsets[d] += level_offsets[d - 1];
+    }
+    order.resize(size());
+    std::vector<size_t> next(level_offsets.begin(), level_offsets.end() - 1);
+    for (uint32_t node = 0; node < alive.size(); node++) {
+        if (alive[node]) order[next[depths[node]]++] = node;
+    }
+    if (order.empty()) level_offsets.clear();
+
+    // Preorder: a depth-first walk from each root along the child links
+    preorder.clear();
+    subtree_end.assign(order.size(), 0);
+    preorder_positions.assign(alive.size(), NONE);
+    std::vector<uint32_t> stack;
+    for (uint32_t root = 0; root < alive.size(); root++) {
+        if (!alive[root] || parents[root] != NONE) continue;
+        stack.push_back(root);
+        while (!stack.empty()) {
+            uint32_t node = stack.back();
+            if (preorder_positions[node] == NONE) {
+                // First visit: place the node, then descend into its first child
+                preorder_positions[node] = (uint32_t)preorder.size();
+                preorder.push_back(node);
+                if (first_child[node] != NONE) {
+                    stack.push_back(first_child[node]);
+                    continue;
+                }
+            }
+            // Subtree finished: close it and move on to the next sibling
+            stack.pop_back();
+            subtree_end[preorder_positions[node]] = (uint32_t)preorder.size();
+            if (next_sibling[node] != NONE) stack.push_back(next_sibling[node]);
+        }
+    }
+    order_valid = true;
+}
+
+size_t TransformHierarchy::update(unsigned threads) {
+    if (!order_valid) rebuild_order();
+    for (uint32_t node : changed_nodes) {
+        changed[node] = 0;
+    }
+    changed_nodes.clear();
+    if (dirty_count == 0) {
+        dirty_nodes.clear();
+        return 0;
+    }
+    if (dirty_count * SPARSE_RATIO < size()) {
+        size_t recomputed = update_subtrees();
+        dirty_nodes.clear();
+        dirty_count = 0;
+        return recomputed;
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t d = 0; d + 1 < level_offsets.size(); d++) {
+        size_t first = level_offsets[d];
+        size_t count = level_offsets[d + 1] - first;
+        unsigned level_threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, count / MIN_NODES_PER_THREAD)));
+        if (level_threads <= 1) {
+            update_range(first, first + count, changed_nodes);
+            continue;
+        }
+
+        // Nodes of one depth only read their parent's finished world, so ranges need no locking;
+        // each worker lists its recomputed nodes separately and the lists are appended after the join
+        std::vector<std::thread> workers;
+        std::vector<std::vector<uint32_t>> results(level_threads);
+        size_t per_thread = (count + level_threads - 1) / level_threads;
+        for (unsigned t = 1; t < level_threads; t++) {
+            size_t begin = first + t * per_thread;
+            size_t end = std::min(first + count, begin + per_thread);
+            if (begin >= end) break;
+            workers.emplace_back([this, &results, t, begin, end] { update_range(begin, end, results[t]); });
+        }
+        update_range(first, std::min(first + count, first + per_thread), changed_nodes);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (unsigned t = 1; t < level_threads; t++) {
+            changed_nodes.insert(changed_nodes.end(), results[t].begin(), results[t].end());
+        }
+    }
+    dirty_nodes.clear();
+    dirty_count = 0;
+    return changed_nodes.size();
+}
+
+size_t TransformHierarchy::update_subtrees() {
+    // Removed or re-marked nodes leave stale or repeated entries; repeats are skipped below
+    dirty_positions.clear();
+    for (uint32_t node : dirty_nodes) {
+        if (dirty[node]) dirty_positions.push_back(preorder_positions[node]);
+    }
+    std::sort(dirty_positions.begin(), dirty_positions.end());
+
+    // A dirty node inside an earlier dirty subtree is covered by that walk
+    size_t recomputed = 0;
+    uint32_t covered = 0;
+    for (uint32_t position : dirty_positions) {
+        if (position < covered) continue;
+        covered = subtree_end[position];
+        for (uint32_t p = position; p < covered; p++) {
+            uint32_t node = preorder[p];
+            uint32_t parent = parents[node];
+            worlds[node] = parent == NONE ? locals[node] : worlds[parent] * locals[node];
+            changed[node] = 1;
+            changed_nodes.push_back(node);
+            dirty[node] = 0;
+        }
+        recomputed += covered - position;
+    }
+    return recomputed;
+}
+
+void TransformHierarchy::update_range(size_t first, size_t last, std::vector<uint32_t>& recomputed) {
+    for (size_t i = first; i < last; i++) {
+        uint32_t node = order[i];
+        uint32_t parent = parents[node];
+        bool stale = dirty[node] || (parent != NONE && changed[parent]);
+        changed[node] = stale;
+        if (!stale) continue;
+        worlds[node] = parent == NONE ? locals[node] : worlds[parent] * locals[node];
+        dirty[node] = 0;
+        recomputed.push_back(node);
+    }
+}
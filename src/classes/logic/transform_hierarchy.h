@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Parent/child transform nodes (wheels on a car, props attached to the track,
+// a camera riding a vehicle). Local and world matrices live in flat arrays
+// indexed by node id. update() recomputes the world matrix of every node whose
+// local matrix changed and of everything below it, and nothing else. A few
+// dirty nodes are handled as contiguous subtree ranges of a preorder layout;
+// larger updates go depth by depth, so a parent is always done before its
+// children and the nodes of one depth can be split across threads.
+class TransformHierarchy {
+public:
+    static const uint32_t NONE = UINT32_MAX;
+
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint32_t> parents;
+    std::vector<uint8_t> changed;       // world recomputed by the last update()
+    std::vector<uint32_t> changed_nodes;    // the same nodes as ids, for walking only those
+
+    uint32_t add_node(const glm::mat4& local = glm::mat4(1.0f), uint32_t parent = NONE);
+    // Children keep their world transform and become roots
+    void remove_node(uint32_t node);
+    // Keeps the node's world transform; fails if parent is the node or one of its descendants
+    bool set_parent(uint32_t node, uint32_t parent);
+    void set_local(uint32_t node, const glm::mat4& local);
+    void set_world(uint32_t node, const glm::mat4& world);
+    // Up to date even before update(), walking the parents when needed
+    glm::mat4 current_world(uint32_t node) const;
+    bool contains(uint32_t node) const { return node < alive.size() && alive[node]; }
+    size_t size() const { return alive.size() - free_nodes.size(); }
+    size_t depth_count() const { return level_offsets.empty() ? 0 : level_offsets.size() - 1; }
+    void clear();
+
+    // threads == 0 uses the hardware concurrency; returns the number of nodes recomputed
+    size_t update(unsigned threads = 1);
+
+private:
+    std::vector<uint8_t> dirty;         // local changed since the last update()
+    std::vector<uint8_t> alive;
+    std::vector<uint32_t> free_nodes;
+    std::vector<uint32_t> first_child;  // children of a node as a doubly linked sibling list
+    std::vector<uint32_t> next_sibling;
+    std::vector<uint32_t> prev_sibling;
+    std::vector<uint32_t> order;        // live nodes by depth, then id
+    std::vector<size_t> level_offsets;  // order[level_offsets[d], level_offsets[d + 1]) have depth d
+    std::vector<uint32_t> preorder;     // live nodes, each subtree contiguous
+    std::vector<uint32_t> subtree_end;  // per preorder position, one past the subtree
+    std::vector<uint32_t> preorder_positions;   // node -> position in preorder
+    std::vector<uint32_t> dirty_nodes;          // marked since the last update(), may repeat
+    std::vector<uint32_t> dirty_positions;
+    bool order_valid = true;
+    size_t dirty_count = 0;
+
+    void mark_dirty(uint32_t node);
+    void link(uint32_t node, uint32_t parent);
+    void unlink(uint32_t node);
+    void rebuild_order();
+    size_t update_subtrees();
+    void update_range(size_t first, size_t last, std::vector<uint32_t>& recomputed);
+};
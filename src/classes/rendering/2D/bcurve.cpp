@@ -13,49 +13,77 @@ void BSpline::set_control_points(const std::vector<glm::vec3>& points) {
     controlPoints = points;
 }
 
+void BSpline::setControlPoint(size_t index, const glm::vec3& point) {
+    if (index < controlPoints.size()) {
+        controlPoints[index] = point;
+    }
+}
+
 void BSpline::setStepsPerSegment(int steps) {
     stepsPerSegment = std::max(steps, 10);
 }
 
+glm::vec3 BSpline::evaluatePoint(int i, float t) const {
+    int N = controlPoints.size();
+    int i0 = (i - 1 + N) % N;
+    int i1 = i % N;
+    int i2 = (i + 1) % N;
+    int i3 = (i + 2) % N;
+    
+    float t2 = t * t;
+    float t3 = t2 * t;
+    
+    float B0 = (-t3 + 3*t2 - 3*t + 1) / 6.0f;
+    float B1 = (3*t3 - 6*t2 + 4) / 6.0f;
+    float B2 = (-3*t3 + 3*t2 + 3*t + 1) / 6.0f;
+    float B3 = t3 / 6.0f;
+    
+    return
+        controlPoints[i0] * B0 +
+        controlPoints[i1] * B1 +
+        controlPoints[i2] * B2 +
+        controlPoints[i3] * B3;
+}
+
 std::vector<glm::vec3> BSpline::evaluateCurve() const {
     std::vector<glm::vec3> curvePoints;
+    evaluateCurve(curvePoints);
+    return curvePoints;
+}
+
+void BSpline::evaluateCurve(std::vector<glm::vec3>& curvePoints) const {
+    curvePoints.clear();
     
     if (controlPoints.size() < 4) {
-        return curvePoints;
+        return;
     }
     
     int N = controlPoints.size();
     float inc = 1.0f / stepsPerSegment;
+    curvePoints.reserve(N * stepsPerSegment + 1);
     
     for (int i = 0; i < N; i++) {
-        for (float t = 0; t < 1.0f; t += inc) {
-            int i0 = (i - 1 + N) % N;
-            int i1 = i % N;
-            int i2 = (i + 1) % N;
-            int i3 = (i + 2) % N;
-            
-            float t2 = t * t;
-            float t3 = t2 * t;
-            
-            float B0 = (-t3 + 3*t2 - 3*t + 1) / 6.0f;
-            float B1 = (3*t3 - 6*t2 + 4) / 6.0f;
-            float B2 = (-3*t3 + 3*t2 + 3*t + 1) / 6.0f;
-            float B3 = t3 / 6.0f;
-            
-            glm::vec3 point = 
-                controlPoints[i0] * B0 +
-                controlPoints[i1] * B1 +
-                controlPoints[i2] * B2 +
-                controlPoints[i3] * B3;
-            
-            curvePoints.push_back(point);
+        for (int step = 0; step < stepsPerSegment; step++) {
+            curvePoints.push_back(evaluatePoint(i, step * inc));
         }
     }
     
     if (!curvePoints.empty() && controlPoints.size() >= 4) {
         curvePoints.push_back(curvePoints[0]);
     }
-    
-    return curvePoints;
 }
 
+void BSpline::evaluateSegments(int first, int last, std::vector<glm::vec3>& curvePoints) const {
+    int N = controlPoints.size();
+    if (N < 4 || curvePoints.size() != static_cast<size_t>(N * stepsPerSegment + 1)) {
+        return;
+    }
+    
+    float inc = 1.0f / stepsPerSegment;
+    for (int i = std::max(first, 0); i <= std::min(last, N - 1); i++) {
+        for (int step = 0; step < stepsPerSegment; step++) {
+            curvePoints[i * stepsPerSegment + step] = evaluatePoint(i, step * inc);
+        }
+    }
+    curvePoints.back() = curvePoints[0];
+}
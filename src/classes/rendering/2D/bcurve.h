@@ -7,12 +7,22 @@ private:
     std::vector<glm::vec3> controlPoints;
     int stepsPerSegment = 20;
 
+    glm::vec3 evaluatePoint(int segment, float t) const;
+
 public:
     void addControlPoint(const glm::vec3& point);
     
     void set_control_points(const std::vector<glm::vec3>& points);
+    void setControlPoint(size_t index, const glm::vec3& point);
+    size_t getControlPointCount() const { return controlPoints.size(); }
     
     std::vector<glm::vec3> evaluateCurve() const;
+    // Same samples as evaluateCurve, written into a caller-owned vector to reuse its capacity
+    void evaluateCurve(std::vector<glm::vec3>& curvePoints) const;
+    // Re-evaluates segments [first, last] in place; curvePoints must hold a full evaluateCurve result.
+    // Segment i owns samples [i * stepsPerSegment, (i + 1) * stepsPerSegment).
+    void evaluateSegments(int first, int last, std::vector<glm::vec3>& curvePoints) const;
     
     void setStepsPerSegment(int steps);
-};
\ No newline at end of file
+    int getStepsPerSegment() const { return stepsPerSegment; }
+};
@@ -0,0 +1,205 @@
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <iostream>
+
+#include "track_overlay.h"
+#include "../../logic/stats.h"
+
+namespace {
+
+const GLchar* overlayVertexShader = R"glsl(
+    #version 450 core
+    layout (location = 0) in vec3 position;
+    uniform mat4 view;
+    uniform mat4 projection;
+    uniform float lift;
+    void main() {
+        gl_Position = projection * view * vec4(position + vec3(0.0, lift, 0.0), 1.0);
+        gl_PointSize = 12.0;
+    }
+)glsl";
+
+const GLchar* overlayFragmentShader = R"glsl(
+    #version 450 core
+    uniform int highlight;
+    uniform bool drawLines;
+    uniform vec4 lineColor;
+    out vec4 FragColor;
+    void main() {
+        if (drawLines) {
+            FragColor = lineColor;
+            return;
+        }
+        vec2 coord = gl_PointCoord - vec2(0.5);
+        float dist = length(coord);
+        
+        if(dist > 0.5)
+            discard;
+            
+        if(dist > 0.4) {
+            FragColor = vec4(0.0, 0.0, 0.0, 1.0); 
+        } else if(highlight == 2) {
+            FragColor = vec4(1.0, 0.5, 0.0, 1.0); 
+        } else if(highlight == 1) {
+            FragColor = vec4(1.0, 1.0, 0.0, 1.0); 
+        } else {
+            FragColor = vec4(1.0, 1.0, 1.0, 1.0); 
+        }
+    }
+)glsl";
+
+const float POINT_LIFT = 0.1f;
+const float LINE_LIFT = 0.05f;
+
+}
+
+void TrackOverlay::init() {
+    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &overlayVertexShader, nullptr);
+    glCompileShader(vertexShader);
+    
+    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &overlayFragmentShader, nullptr);
+    glCompileShader(fragmentShader);
+    
+    shader = glCreateProgram();
+    glAttachShader(shader, vertexShader);
+    glAttachShader(shader, fragmentShader);
+    glLinkProgram(shader);
+    
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    view_loc = glGetUniformLocation(shader, "view");
+    projection_loc = glGetUniformLocation(shader, "projection");
+    lift_loc = glGetUniformLocation(shader, "lift");
+    highlight_loc = glGetUniformLocation(shader, "highlight");
+    lines_loc = glGetUniformLocation(shader, "drawLines");
+    color_loc = glGetUniformLocation(shader, "lineColor");
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
+
+// Grows the buffer by doubling; the old contents are dropped, so everything is re-uploaded
+void TrackOverlay::reserve(const TrackEditor& editor, size_t points, size_t samples) {
+    if (points <= point_capacity && samples <= sample_capacity) return;
+
+    size_t old_bytes = (point_capacity + sample_capacity) * sizeof(glm::vec3);
+    point_capacity = std::max(std::max(points, point_capacity * 2), size_t(64));
+    sample_capacity = std::max(std::max(samples, sample_capacity * 2), size_t(1024));
+    Stats::add(Stats::GPU_BUFFER_BYTES, (int64_t)((point_capacity + sample_capacity) * sizeof(glm::vec3) - old_bytes));
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, (point_capacity + sample_capacity) * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
+
+    if (points > 0) upload_points(editor, 0, points - 1);
+    if (samples > 0) upload_samples(editor, 0, samples - 1);
+}
+
+void TrackOverlay::upload_points(const TrackEditor& editor, size_t first, size_t last) {
+    staging.resize(last - first + 1);
+    for (size_t i = first; i <= last; i++) {
+        const glm::vec2& p = editor.control_points[i];
+        staging[i - first] = glm::vec3(p.x, editor.point_attributes[i].elevation, p.y);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3), staging.size() * sizeof(glm::vec3), staging.data());
+    bytes_uploaded += staging.size() * sizeof(glm::vec3);
+    Stats::add(Stats::BUFFER_UPLOAD_BYTES, (int64_t)(staging.size() * sizeof(glm::vec3)));
+}
+
+void TrackOverlay::upload_samples(const TrackEditor& editor, size_t first, size_t last) {
+    const auto& samples = editor.curve_samples();
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, (point_capacity + first) * sizeof(glm::vec3),
+                    (last - first + 1) * sizeof(glm::vec3), &samples[first]);
+    bytes_uploaded += (last - first + 1) * sizeof(glm::vec3);
+    Stats::add(Stats::BUFFER_UPLOAD_BYTES, (int64_t)((last - first + 1) * sizeof(glm::vec3)));
+}
+
+void TrackOverlay::sync(TrackEditor& editor) {
+    bytes_uploaded = 0;
+    if (editor.revision == synced_revision) return;
+    synced_revision = editor.revision;
+
+    // The centerline only matches the points once a track has been generated from them
+    size_t points = editor.control_points.size();
+    size_t samples = editor.curve_samples().size();
+    size_t expected = points * editor.center_spline.getStepsPerSegment() + 1;
+    if (points < 4 || samples != expected) samples = 0;
+
+    size_t first, last;
+    bool points_changed = editor.take_point_changes(first, last);
+    size_t sample_first, sample_last;
+    bool samples_changed = editor.take_sample_changes(sample_first, sample_last);
+
+    if (points > point_capacity || samples > sample_capacity) {
+        reserve(editor, points, samples);
+    } else {
+        if (points_changed) upload_points(editor, first, last);
+        if (samples_changed && samples > 0) upload_samples(editor, sample_first, std::min(sample_last, samples - 1));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    point_count = points;
+    sample_count = samples;
+}
+
+void TrackOverlay::render(const glm::mat4& view, const glm::mat4& projection, int hovered, int selected) const {
+    if (point_count == 0) return;
+
+    glUseProgram(shader);
+    glUniformMatrix4fv(view_loc, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(projection_loc, 1, GL_FALSE, glm::value_ptr(projection));
+    glBindVertexArray(VAO);
+
+    glUniform1i(lines_loc, 1);
+    glUniform1f(lift_loc, LINE_LIFT);
+    if (show_polygon && point_count > 1) {
+        glUniform4f(color_loc, 0.6f, 0.6f, 0.6f, 0.6f);
+        glDrawArrays(GL_LINE_LOOP, 0, point_count);
+    }
+    if (show_spline && sample_count > 1) {
+        glUniform4f(color_loc, 0.2f, 0.8f, 1.0f, 1.0f);
+        glDrawArrays(GL_LINE_STRIP, point_capacity, sample_count);
+    }
+
+    glUniform1i(lines_loc, 0);
+    glUniform1f(lift_loc, POINT_LIFT);
+    glUniform1i(highlight_loc, 0);
+    glDrawArrays(GL_POINTS, 0, point_count);
+    if (hovered >= 0 && hovered < (int)point_count) {
+        glUniform1i(highlight_loc, 1);
+        glDrawArrays(GL_POINTS, hovered, 1);
+    }
+    if (selected >= 0 && selected < (int)point_count) {
+        glUniform1i(highlight_loc, 2);
+        glDrawArrays(GL_POINTS, selected, 1);
+    }
+    glBindVertexArray(0);
+}
+
+void TrackOverlay::cleanup() {
+    if (VAO) {
+        glDeleteVertexArrays(1, &VAO);
+        VAO = 0;
+    }
+    if (VBO) {
+        glDeleteBuffers(1, &VBO);
+        VBO = 0;
+    }
+    if (shader) {
+        glDeleteProgram(shader);
+        shader = 0;
+    }
+    Stats::add(Stats::GPU_BUFFER_BYTES, -(int64_t)((point_capacity + sample_capacity) * sizeof(glm::vec3)));
+    point_capacity = sample_capacity = 0;
+    point_count = sample_count = 0;
+    synced_revision = UINT64_MAX;
+}
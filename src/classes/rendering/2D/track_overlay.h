@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "../../logic/track_editor.h"
+
+// Editor overlay for the track: control points, the control polygon and the
+// sampled centerline. Everything lives in one persistent vertex buffer laid out
+// as [control points | centerline samples]; sync() only uploads the ranges the
+// editor reports as changed and reallocates when a region runs out of room.
+class TrackOverlay {
+public:
+    GLuint VAO = 0, VBO = 0, shader = 0;
+    bool show_polygon = true;
+    bool show_spline = true;
+    size_t bytes_uploaded = 0;   // by the last sync()
+
+    void init();
+    void sync(TrackEditor& editor);
+    void render(const glm::mat4& view, const glm::mat4& projection, int hovered, int selected) const;
+    void cleanup();
+
+private:
+    GLint view_loc = -1, projection_loc = -1, lift_loc = -1, highlight_loc = -1, lines_loc = -1, color_loc = -1;
+    size_t point_capacity = 0, sample_capacity = 0;
+    size_t point_count = 0, sample_count = 0;
+    uint64_t synced_revision = UINT64_MAX;
+    std::vector<glm::vec3> staging;
+
+    void reserve(const TrackEditor& editor, size_t points, size_t samples);
+    void upload_points(const TrackEditor& editor, size_t first, size_t last);
+    void upload_samples(const TrackEditor& editor, size_t first, size_t last);
+};
@@ -1,22 +1,81 @@
 #include "animation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
+#include "../../logic/buffered_writer.h"
+#include "../../logic/checksum.h"
+#include "../../logic/mapped_file.h"
+
+namespace {
+
+size_t align_keyframes(size_t offset) {
+    return (offset + 15) & ~size_t(15);
+}
+
+// Entries a cursor steps forward before giving up and searching the rest
+const size_t CURSOR_STEPS = 8;
+
+// Index i in [0, last] with table[i] <= value < table[i + 1] (clamped), for a sorted
+// table. Starts at *cursor when the value has not moved backwards past it.
+size_t find_entry(const std::vector<float>& table, float value, size_t* cursor) {
+    size_t last = table.size() - 2;
+    size_t first = 0;
+    if (cursor && *cursor <= last && table[*cursor] <= value) {
+        size_t i = *cursor;
+        size_t limit = std::min(last, i + CURSOR_STEPS);
+        while (i < limit && table[i + 1] <= value) i++;
+        if (i < limit || i == last || table[i + 1] > value) {
+            *cursor = i;
+            return i;
+        }
+        first = i;
+    }
+    size_t i = std::upper_bound(table.begin() + first, table.end(), value) - table.begin();
+    i = std::min(i == 0 ? 0 : i - 1, last);
+    if (cursor) *cursor = i;
+    return i;
+}
+
+AnimationSample make_sample(const glm::vec3& position, const glm::vec3& direction) {
+    AnimationSample sample;
+    sample.position = position;
+    float length = glm::length(direction);
+    sample.tangent = length > 1e-12f ? direction / length : glm::vec3(0.0f, 0.0f, 1.0f);
+    sample.heading = std::atan2(sample.tangent.x, sample.tangent.z);
+    return sample;
+}
+
+}
+
 void Animation::add_keyframe(const glm::vec3& position) {
     keyframes.push_back(position);
 }
 
-glm::vec3 Animation::get_position_at_time(float time) const {
-    if (keyframes.empty()) return glm::vec3(0.0f);
-    if (keyframes.size() == 1) return keyframes[0];
-    
+float Animation::wrap_time(float time) const {
     if (looping) {
         time = fmod(time, duration);
-    } else {
-        time = glm::clamp(time, 0.0f, duration);
+        if (time < 0.0f) time += duration;
+        return time;
+    }
+    return glm::clamp(time, 0.0f, duration);
+}
+
+glm::vec3 Animation::get_position_at_time(float time, size_t* cursor) const {
+    if (keyframes.empty()) return glm::vec3(0.0f);
+    if (keyframes.size() == 1) return keyframes[0];
+    if (timed) {
+        return sample_timed(time, cursor).position;
+    }
+    if (constant_speed && !arc_lengths.empty()) {
+        return sample_arc_length(time, cursor).position;
     }
     
+    time = wrap_time(time);
+    
     float segmentDuration = duration / (keyframes.size() - 1);
     int segment = static_cast<int>(time / segmentDuration);
     float t = (time - segment * segmentDuration) / segmentDuration;
@@ -28,6 +87,136 @@ glm::vec3 Animation::get_position_at_time(float time) const {
     return glm::mix(keyframes[segment], keyframes[segment + 1], t);
 }
 
+AnimationSample Animation::sample(float time, size_t* cursor) const {
+    if (keyframes.empty()) return make_sample(glm::vec3(0.0f), glm::vec3(0.0f));
+    if (keyframes.size() == 1) return make_sample(keyframes[0], glm::vec3(0.0f));
+    if (timed) {
+        return sample_timed(time, cursor);
+    }
+    if (constant_speed && !arc_lengths.empty()) {
+        return sample_arc_length(time, cursor);
+    }
+    return sample_linear(time);
+}
+
+AnimationSample Animation::sample_linear(float time) const {
+    time = wrap_time(time);
+
+    float segmentDuration = duration / (keyframes.size() - 1);
+    size_t segment = std::min(static_cast<size_t>(time / segmentDuration), keyframes.size() - 2);
+    float t = glm::clamp((time - segment * segmentDuration) / segmentDuration, 0.0f, 1.0f);
+
+    const glm::vec3& a = keyframes[segment];
+    const glm::vec3& b = keyframes[segment + 1];
+    return make_sample(glm::mix(a, b, t), b - a);
+}
+
+void Animation::prepare_timestamps() {
+    timed = false;
+    if (timestamps.empty()) return;
+
+    bool valid = timestamps.size() == keyframes.size() && timestamps.size() >= 2;
+    for (size_t i = 1; valid && i < timestamps.size(); i++) {
+        valid = timestamps[i] >= timestamps[i - 1];
+    }
+    float span = valid ? timestamps.back() - timestamps.front() : 0.0f;
+    if (!valid || span <= 0.0f) {
+        std::cerr << "Warning: ignoring invalid keyframe timestamps in animation " << name << std::endl;
+        timestamps.clear();
+        return;
+    }
+    duration = span;
+
+    // Evenly spaced samples are what the uniform path assumes already
+    float step = span / (timestamps.size() - 1);
+    for (size_t i = 1; i < timestamps.size(); i++) {
+        float expected = timestamps.front() + step * i;
+        if (std::fabs(timestamps[i] - expected) > step * 1e-3f) {
+            timed = true;
+            return;
+        }
+    }
+}
+
+// Linear interpolation between the timestamps around `time`, measured from the first keyframe
+AnimationSample Animation::sample_timed(float time, size_t* cursor) const {
+    float t = timestamps.front() + wrap_time(time);
+
+    size_t i = find_entry(timestamps, t, cursor);
+
+    float span = timestamps[i + 1] - timestamps[i];
+    float f = span > 0.0f ? glm::clamp((t - timestamps[i]) / span, 0.0f, 1.0f) : 1.0f;
+    const glm::vec3& a = keyframes[i];
+    const glm::vec3& b = keyframes[i + 1];
+    return make_sample(glm::mix(a, b, f), b - a);
+}
+
+// Uniform Catmull-Rom through the keyframes at parameter u (segment index plus
+// fraction). Closed paths wrap around, open ones repeat their end points.
+glm::vec3 Animation::curve_point(float u, glm::vec3& derivative) const {
+    int n = static_cast<int>(curve_points);
+    int segment = std::min(static_cast<int>(u), looping ? n - 1 : n - 2);
+    float t = u - segment;
+
+    auto at = [&](int i) -> const glm::vec3& {
+        if (looping) return keyframes[(i % n + n) % n];
+        return keyframes[glm::clamp(i, 0, n - 1)];
+    };
+    const glm::vec3& p0 = at(segment - 1);
+    const glm::vec3& p1 = at(segment);
+    const glm::vec3& p2 = at(segment + 1);
+    const glm::vec3& p3 = at(segment + 2);
+
+    glm::vec3 a = p1 * 2.0f;
+    glm::vec3 b = p2 - p0;
+    glm::vec3 c = p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3;
+    glm::vec3 d = -p0 + p1 * 3.0f - p2 * 3.0f + p3;
+
+    derivative = (b + c * (2.0f * t) + d * (3.0f * t * t)) * 0.5f;
+    return (a + b * t + c * (t * t) + d * (t * t * t)) * 0.5f;
+}
+
+void Animation::build_arc_length_table(int subdivisions) {
+    arc_lengths.clear();
+    arc_subdivisions = std::max(subdivisions, 1);
+
+    // Recorded closed paths repeat their first point at the end
+    curve_points = keyframes.size();
+    if (looping && curve_points > 2 && keyframes.front() == keyframes.back()) {
+        curve_points--;
+    }
+    if (curve_points < 2) return;
+
+    size_t segments = looping ? curve_points : curve_points - 1;
+    size_t entries = segments * arc_subdivisions;
+    arc_lengths.reserve(entries + 1);
+    arc_lengths.push_back(0.0f);
+
+    glm::vec3 derivative;
+    glm::vec3 previous = curve_point(0.0f, derivative);
+    float length = 0.0f;
+    for (size_t i = 1; i <= entries; i++) {
+        glm::vec3 point = curve_point(static_cast<float>(i) / arc_subdivisions, derivative);
+        length += glm::distance(previous, point);
+        arc_lengths.push_back(length);
+        previous = point;
+    }
+}
+
+AnimationSample Animation::sample_arc_length(float time, size_t* cursor) const {
+    float distance = wrap_time(time) / duration * arc_lengths.back();
+
+    size_t i = find_entry(arc_lengths, distance, cursor);
+
+    float span = arc_lengths[i + 1] - arc_lengths[i];
+    float f = span > 0.0f ? glm::clamp((distance - arc_lengths[i]) / span, 0.0f, 1.0f) : 0.0f;
+    float u = (static_cast<float>(i) + f) / arc_subdivisions;
+
+    glm::vec3 derivative;
+    glm::vec3 position = curve_point(u, derivative);
+    return make_sample(position, derivative);
+}
+
 void Animation::load_from_file(const std::string& filename) {
     //keyframes.clear();
     std::ifstream file(filename);
@@ -63,4 +252,93 @@ void Animation::save_to_file(const std::string& filename) const {
         file << point.x << " " << point.y << " " << point.z << "\n";
     }
     file.close();
-}
\ No newline at end of file
+}
+
+bool Animation::save_binary(const std::string& filename) const {
+    bool timed = !timestamps.empty() && timestamps.size() == keyframes.size();
+
+    KeyframeFileHeader header;
+    header.count = keyframes.size();
+    header.duration = duration;
+    header.flags = (looping ? KEYFRAME_LOOPING : 0) | (timed ? KEYFRAME_TIMESTAMPS : 0);
+
+    BufferedWriter file;
+    file.buffer.resize(align_keyframes(sizeof(KeyframeFileHeader)), '\0');
+    header.positions_offset = file.buffer.size();
+    file.buffer.append(reinterpret_cast<const char*>(keyframes.data()), keyframes.size() * sizeof(glm::vec3));
+    if (timed) {
+        file.buffer.resize(align_keyframes(file.buffer.size()), '\0');
+        header.timestamps_offset = file.buffer.size();
+        file.buffer.append(reinterpret_cast<const char*>(timestamps.data()), timestamps.size() * sizeof(float));
+    }
+
+    size_t body = align_keyframes(sizeof(KeyframeFileHeader));
+    header.checksum = fnv1a(file.buffer.data() + body, file.buffer.size() - body);
+    std::memcpy(&file.buffer[0], &header, sizeof(KeyframeFileHeader));
+    return file.write_to_file(filename);
+}
+
+bool Animation::load_binary(const std::string& filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+    KeyframeFileHeader header;
+    if (file.size() < sizeof(KeyframeFileHeader)) {
+        std::cerr << "Error: " << filename << " is not a keyframe file" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(KeyframeFileHeader));
+    if (std::memcmp(header.magic, "RKEY", 4) != 0 || header.version != 1 ||
+        (header.up_axis != 1 && header.up_axis != 2)) {
+        std::cerr << "Error: " << filename << " is not a supported keyframe file" << std::endl;
+        return false;
+    }
+
+    bool timed = (header.flags & KEYFRAME_TIMESTAMPS) != 0;
+    // Compared piecewise so a corrupt header cannot wrap the end offsets around
+    auto fits = [&](uint64_t offset, size_t stride) {
+        return offset <= file.size() && header.count <= (file.size() - offset) / stride;
+    };
+    if (!fits(header.positions_offset, sizeof(glm::vec3)) || (timed && !fits(header.timestamps_offset, sizeof(float)))) {
+        std::cerr << "Error: Keyframe file " << filename << " is truncated" << std::endl;
+        return false;
+    }
+    size_t body = align_keyframes(sizeof(KeyframeFileHeader));
+    if (fnv1a(file.data() + body, file.size() - body) != header.checksum) {
+        std::cerr << "Error: Keyframe file " << filename << " failed checksum" << std::endl;
+        return false;
+    }
+
+    keyframes.resize(header.count);
+    std::memcpy(keyframes.data(), file.data() + header.positions_offset, header.count * sizeof(glm::vec3));
+    if (header.up_axis == 2) {
+        for (auto& point : keyframes) {
+            std::swap(point.y, point.z);
+        }
+    }
+    timestamps.clear();
+    if (timed) {
+        timestamps.resize(header.count);
+        std::memcpy(timestamps.data(), file.data() + header.timestamps_offset, header.count * sizeof(float));
+    }
+    duration = header.duration > 0.0f ? header.duration : duration;
+    looping = (header.flags & KEYFRAME_LOOPING) != 0;
+    arc_lengths.clear();
+    prepare_timestamps();
+    return true;
+}
+
+bool Animation::convert_text_to_binary(const std::string& text_file, const std::string& binary_file) {
+    Animation animation;
+    animation.load_from_file(text_file);
+    if (animation.keyframes.empty()) {
+        return false;
+    }
+    if (!animation.save_binary(binary_file)) {
+        return false;
+    }
+    std::cout << "Converted " << text_file << " to " << binary_file << " (" << animation.keyframes.size()
+              << " keyframes)" << std::endl;
+    return true;
+}
@@ -1,19 +1,89 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp>
 #include <string>
 
+// Binary keyframe file (.rkey): the header, then `count` float[3] positions and,
+// with KEYFRAME_TIMESTAMPS, `count` float timestamps in seconds. Both arrays are
+// 16-byte aligned and covered by one FNV-1a checksum.
+struct KeyframeFileHeader {
+    char magic[4] = {'R', 'K', 'E', 'Y'};
+    uint32_t version = 1;
+    uint64_t count = 0;
+    uint32_t up_axis = 1;           // component of the stored positions that points up: 1 = y, 2 = z
+    uint32_t flags = 0;
+    float duration = 0.0f;
+    uint32_t checksum = 0;
+    uint64_t positions_offset = 0;
+    uint64_t timestamps_offset = 0;
+};
+
+// Position and direction of travel along an animation path
+struct AnimationSample {
+    glm::vec3 position;
+    glm::vec3 tangent;      // unit length
+    float heading;          // rotation about +y, atan2(tangent.x, tangent.z)
+};
+
 class Animation {
 public:
     std::string name;
     std::vector<glm::vec3> keyframes;
     std::vector<glm::vec3> points;
+    // Optional time of each keyframe in seconds, non-decreasing. When present playback
+    // follows them (recorded telemetry) instead of spreading duration evenly; call
+    // prepare_timestamps after changing them (load_binary does)
+    std::vector<float> timestamps;
     float duration = 10.0f;
     bool looping = true;
+
+    // When set (and build_arc_length_table has run) the path is a Catmull-Rom curve
+    // through the keyframes, travelled at constant speed over duration.
+    // Otherwise keyframes are linearly interpolated with equal time per segment.
+    bool constant_speed = false;
     
     void add_keyframe(const glm::vec3& position);
-    glm::vec3 get_position_at_time(float time) const;
+    // cursor, when given, caches where the last lookup landed so steadily increasing
+    // times are found in amortised O(1) instead of by binary search; each follower
+    // keeps its own. Keyframes without timestamps (or evenly spaced ones) need no
+    // search at all.
+    glm::vec3 get_position_at_time(float time, size_t* cursor = nullptr) const;
+    // Position, tangent and heading in one query
+    AnimationSample sample(float time, size_t* cursor = nullptr) const;
+    // Checks timestamps and picks the lookup strategy: evenly spaced timestamps keep the
+    // O(1) uniform path (with duration taken from them), anything else is searched.
+    // Invalid timestamps (wrong count, decreasing) are dropped.
+    void prepare_timestamps();
+    bool has_timestamps() const { return timed; }
+    // Samples every keyframe segment at `subdivisions` points and stores the running
+    // arc length; call again after changing keyframes
+    void build_arc_length_table(int subdivisions = 8);
+    float path_length() const { return arc_lengths.empty() ? 0.0f : arc_lengths.back(); }
+
+    static constexpr uint32_t KEYFRAME_LOOPING = 1u << 0;
+    static constexpr uint32_t KEYFRAME_TIMESTAMPS = 1u << 1;
+
     void load_from_file(const std::string& filename);
     void save_to_file(const std::string& filename) const;
-};
\ No newline at end of file
+    // Binary keyframes: mapped and bulk-copied into keyframes/timestamps, no parsing.
+    // Replaces the current keyframes, duration and looping.
+    bool load_binary(const std::string& filename);
+    bool save_binary(const std::string& filename) const;
+    // Reads a text animation file (x z y per line, as written by the track exporter)
+    // and writes it as binary keyframes
+    static bool convert_text_to_binary(const std::string& text_file, const std::string& binary_file);
+
+private:
+    bool timed = false;                 // timestamps are valid and unevenly spaced
+    std::vector<float> arc_lengths;     // arc length at table entry i, parameter u = i / arc_subdivisions
+    int arc_subdivisions = 8;
+    size_t curve_points = 0;            // keyframes on the curve, without a repeated closing keyframe
+
+    float wrap_time(float time) const;
+    glm::vec3 curve_point(float u, glm::vec3& derivative) const;
+    AnimationSample sample_linear(float time) const;
+    AnimationSample sample_timed(float time, size_t* cursor) const;
+    AnimationSample sample_arc_length(float time, size_t* cursor) const;
+};
@@ -0,0 +1,249 @@
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+
+#include "geometry_pool.h"
+#include "../../logic/stats.h"
+
+namespace {
+
+struct VertexKey {
+    float data[GeometryPool::VERTEX_FLOATS];
+    bool operator==(const VertexKey& other) const { return std::memcmp(data, other.data, sizeof(data)) == 0; }
+};
+
+struct VertexKeyHash {
+    size_t operator()(const VertexKey& key) const {
+        uint32_t hash = 2166136261u;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.data);
+        for (size_t i = 0; i < sizeof(key.data); i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+};
+
+}
+
+void GeometryPool::init(size_t vertices, size_t indices) {
+    if (VAO) return;
+
+    vertex_capacity = vertices;
+    index_capacity = indices;
+    free_vertices = {{0, (uint32_t)vertices}};
+    free_indices = {{0, (uint32_t)indices}};
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glGenBuffers(1, &draw_VBO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertex_capacity * VERTEX_FLOATS * sizeof(float), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_capacity * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    bind_attributes();
+    Stats::add(Stats::GPU_BUFFER_BYTES, (int64_t)gpu_bytes());
+}
+
+void GeometryPool::bind_attributes() {
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof(float), (void*)(5 * sizeof(float)));
+
+    glBindBuffer(GL_ARRAY_BUFFER, draw_VBO);
+    for (GLuint column = 0; column < 4; column++) {
+        glEnableVertexAttribArray(3 + column);
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(3 + column, 1);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool GeometryPool::is_pooled(const Mesh& mesh) {
+    // Groups without faces (an `o` line before the first `g`) never get a range
+    bool any = false;
+    for (const auto& group : mesh.groups) {
+        if (group->faces.empty()) continue;
+        if (group->pool.index_count == 0) return false;
+        any = true;
+    }
+    return any;
+}
+
+bool GeometryPool::add(const Obj3D& obj) {
+    if (!obj.mesh) return false;
+    Mesh& mesh = *obj.mesh;
+    for (const auto& group : mesh.groups) {
+        if (group->has_bounds || !group->lods.empty()) return false;
+        // Shared meshes come through once per object; pack them only the first time
+        if (group->pool.index_count > 0) return is_pooled(mesh);
+    }
+
+    std::vector<float> interleaved;
+    std::vector<float> unique;
+    std::vector<uint32_t> indices;
+    std::unordered_map<VertexKey, uint32_t, VertexKeyHash> seen;
+    for (const auto& group : mesh.groups) {
+        if (group->faces.empty()) continue;
+        int count = obj.build_group_vertices(*group, interleaved);
+        if (count == 0) {
+            remove(mesh);
+            return false;
+        }
+
+        unique.clear();
+        indices.clear();
+        seen.clear();
+        for (int i = 0; i < count; i++) {
+            VertexKey key;
+            std::memcpy(key.data, &interleaved[i * VERTEX_FLOATS], sizeof(key.data));
+            auto inserted = seen.emplace(key, (uint32_t)(unique.size() / VERTEX_FLOATS));
+            if (inserted.second) {
+                unique.insert(unique.end(), key.data, key.data + VERTEX_FLOATS);
+            }
+            indices.push_back(inserted.first->second);
+        }
+
+        uint32_t vertex_count = unique.size() / VERTEX_FLOATS;
+        uint32_t first_vertex, first_index;
+        if (!allocate(free_vertices, vertex_count, first_vertex)) {
+            grow(VBO, vertex_capacity, vertex_count, VERTEX_FLOATS * sizeof(float), free_vertices);
+            if (!allocate(free_vertices, vertex_count, first_vertex)) {
+                // Give back the groups packed so far so the mesh stays on its own buffers
+                remove(mesh);
+                return false;
+            }
+        }
+        if (!allocate(free_indices, indices.size(), first_index)) {
+            grow(EBO, index_capacity, indices.size(), sizeof(uint32_t), free_indices);
+            if (!allocate(free_indices, indices.size(), first_index)) {
+                release(free_vertices, first_vertex, vertex_count);
+                remove(mesh);
+                return false;
+            }
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, (size_t)first_vertex * VERTEX_FLOATS * sizeof(float),
+                        unique.size() * sizeof(float), unique.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // Index data goes through GL_COPY_WRITE_BUFFER so the VAO's element binding is left alone
+        glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)first_index * sizeof(uint32_t),
+                        indices.size() * sizeof(uint32_t), indices.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        Stats::add(Stats::BUFFER_UPLOAD_BYTES, (int64_t)(unique.size() * sizeof(float) + indices.size() * sizeof(uint32_t)));
+
+        group->pool.first_vertex = first_vertex;
+        group->pool.vertex_count = vertex_count;
+        group->pool.first_index = first_index;
+        group->pool.index_count = indices.size();
+        vertices_used += vertex_count;
+        indices_used += indices.size();
+    }
+    return is_pooled(mesh);
+}
+
+void GeometryPool::remove(Mesh& mesh) {
+    for (const auto& group : mesh.groups) {
+        if (group->pool.index_count == 0) continue;
+        release(free_vertices, group->pool.first_vertex, group->pool.vertex_count);
+        release(free_indices, group->pool.first_index, group->pool.index_count);
+        vertices_used -= group->pool.vertex_count;
+        indices_used -= group->pool.index_count;
+        group->pool = PoolRange();
+    }
+}
+
+bool GeometryPool::allocate(std::vector<Span>& free_list, uint32_t count, uint32_t& offset) {
+    for (auto it = free_list.begin(); it != free_list.end(); ++it) {
+        if (it->count < count) continue;
+        offset = it->offset;
+        it->offset += count;
+        it->count -= count;
+        if (it->count == 0) free_list.erase(it);
+        return true;
+    }
+    return false;
+}
+
+void GeometryPool::release(std::vector<Span>& free_list, uint32_t offset, uint32_t count) {
+    auto it = std::lower_bound(free_list.begin(), free_list.end(), offset,
+                               [](const Span& span, uint32_t value) { return span.offset < value; });
+    it = free_list.insert(it, {offset, count});
+
+    // Coalesce with the following and preceding spans
+    auto next = it + 1;
+    if (next != free_list.end() && it->offset + it->count == next->offset) {
+        it->count += next->count;
+        free_list.erase(next);
+    }
+    if (it != free_list.begin()) {
+        auto prev = it - 1;
+        if (prev->offset + prev->count == it->offset) {
+            prev->count += it->count;
+            free_list.erase(it);
+        }
+    }
+}
+
+void GeometryPool::grow(GLuint& buffer, size_t& capacity, size_t needed, size_t unit_bytes, std::vector<Span>& free_list) {
+    size_t new_capacity = std::max(capacity * 2, capacity + needed);
+
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, new_capacity * unit_bytes, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity * unit_bytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    buffer = grown;
+
+    release(free_list, capacity, new_capacity - capacity);
+    Stats::add(Stats::GPU_BUFFER_BYTES, (int64_t)((new_capacity - capacity) * unit_bytes));
+    capacity = new_capacity;
+    bind_attributes();
+}
+
+void GeometryPool::upload_draw_data(const std::vector<glm::mat4>& transforms) {
+    glBindBuffer(GL_ARRAY_BUFFER, draw_VBO);
+    if (transforms.size() > draw_capacity) {
+        size_t grown = std::max(transforms.size(), draw_capacity * 2);
+        Stats::add(Stats::GPU_BUFFER_BYTES, (int64_t)((grown - draw_capacity) * sizeof(glm::mat4)));
+        draw_capacity = grown;
+    }
+    glBufferData(GL_ARRAY_BUFFER, draw_capacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, transforms.size() * sizeof(glm::mat4), transforms.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    Stats::add(Stats::BUFFER_UPLOAD_BYTES, (int64_t)(transforms.size() * sizeof(glm::mat4)));
+}
+
+size_t GeometryPool::gpu_bytes() const {
+    return vertex_capacity * VERTEX_FLOATS * sizeof(float) + index_capacity * sizeof(uint32_t) +
+           draw_capacity * sizeof(glm::mat4);
+}
+
+void GeometryPool::cleanup() {
+    Stats::add(Stats::GPU_BUFFER_BYTES, -(int64_t)gpu_bytes());
+    if (VAO) glDeleteVertexArrays(1, &VAO);
+    if (VBO) glDeleteBuffers(1, &VBO);
+    if (EBO) glDeleteBuffers(1, &EBO);
+    if (draw_VBO) glDeleteBuffers(1, &draw_VBO);
+    VAO = VBO = EBO = draw_VBO = 0;
+    vertex_capacity = index_capacity = draw_capacity = 0;
+    vertices_used = indices_used = 0;
+    free_vertices.clear();
+    free_indices.clear();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+
+#include "obj3d.h"
+
+// Static meshes packed into one shared vertex buffer and one index buffer, so
+// a whole frame can be drawn from a single VAO. Groups get suballocated
+// ranges (first fit over a sorted free list); identical vertices inside a
+// group are merged when the index buffer is built. The VAO also carries the
+// per-draw model matrices as attributes 3-6 with divisor 1.
+class GeometryPool {
+public:
+    static const size_t VERTEX_FLOATS = 8;
+
+    GLuint VAO = 0, VBO = 0, EBO = 0, draw_VBO = 0;
+    size_t vertex_capacity = 0, index_capacity = 0, draw_capacity = 0;
+    size_t vertices_used = 0, indices_used = 0;
+
+    void init(size_t vertices, size_t indices);
+    // Packs every group of the object's mesh the first time it is seen; meshes with chunk
+    // bounds or LODs are refused, and a mesh that does not fit is left unpooled
+    bool add(const Obj3D& obj);
+    void remove(Mesh& mesh);
+    static bool is_pooled(const Mesh& mesh);
+    void upload_draw_data(const std::vector<glm::mat4>& transforms);
+    size_t gpu_bytes() const;
+    void cleanup();
+
+private:
+    struct Span { uint32_t offset, count; };
+    std::vector<Span> free_vertices, free_indices;
+
+    static bool allocate(std::vector<Span>& free_list, uint32_t count, uint32_t& offset);
+    static void release(std::vector<Span>& free_list, uint32_t offset, uint32_t count);
+    void grow(GLuint& buffer, size_t& capacity, size_t needed, size_t unit_bytes, std::vector<Span>& free_list);
+    void bind_attributes();
+};
@@ -0,0 +1,50 @@
+#include "gpu_timer.h"
+
+void GpuTimer::begin(const char* name) {
+    if (open) end();
+    Frame& frame = frames[current];
+    if (frame.used == frame.passes.size()) {
+        Pass pass{name, 0, 0};
+        glGenQueries(1, &pass.query);
+        frame.passes.push_back(pass);
+    }
+    Pass& pass = frame.passes[frame.used++];
+    pass.name = name;
+    pass.cpu_begin_ns = Profiler::now_ns();
+    glBeginQuery(GL_TIME_ELAPSED, pass.query);
+    open = true;
+}
+
+void GpuTimer::end() {
+    if (!open) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    open = false;
+}
+
+void GpuTimer::collect() {
+    if (open) end();
+    current = (current + 1) % FRAMES_IN_FLIGHT;
+
+    // The slot being reused was filled FRAMES_IN_FLIGHT - 1 frames ago
+    Frame& frame = frames[current];
+    for (size_t i = 0; i < frame.used; i++) {
+        Pass& pass = frame.passes[i];
+        GLint available = 0;
+        glGetQueryObjectiv(pass.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;   // still in flight after several frames; skip rather than stall
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(pass.query, GL_QUERY_RESULT, &elapsed);
+        Profiler::record_gpu(pass.name, pass.cpu_begin_ns, elapsed);
+    }
+    frame.used = 0;
+}
+
+void GpuTimer::cleanup() {
+    for (auto& frame : frames) {
+        for (auto& pass : frame.passes) {
+            glDeleteQueries(1, &pass.query);
+        }
+        frame.passes.clear();
+        frame.used = 0;
+    }
+}
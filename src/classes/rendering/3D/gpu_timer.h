@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+
+#include "../../logic/profiler.h"
+
+#ifdef RACETRACK_PROFILE
+#define PROFILE_GPU_BEGIN(timer, name) (timer).begin(name)
+#define PROFILE_GPU_END(timer) (timer).end()
+#define PROFILE_GPU_COLLECT(timer) (timer).collect()
+#else
+#define PROFILE_GPU_BEGIN(timer, name) ((void)0)
+#define PROFILE_GPU_END(timer) ((void)0)
+#define PROFILE_GPU_COLLECT(timer) ((void)0)
+#endif
+
+// GL_TIME_ELAPSED queries around GPU passes. Queries are read a few frames
+// later, once available, so timing never stalls the pipeline; results go to
+// the Profiler's GPU row. Passes cannot nest (one TIME_ELAPSED query at a time).
+class GpuTimer {
+public:
+    static const size_t FRAMES_IN_FLIGHT = 4;
+
+    void begin(const char* name);
+    void end();
+    // Call once per frame: reads finished queries and starts a new frame slot
+    void collect();
+    void cleanup();
+
+private:
+    struct Pass {
+        const char* name;
+        GLuint query;
+        uint64_t cpu_begin_ns;
+    };
+    struct Frame {
+        std::vector<Pass> passes;
+        size_t used = 0;
+    };
+    Frame frames[FRAMES_IN_FLIGHT];
+    size_t current = 0;
+    bool open = false;
+};
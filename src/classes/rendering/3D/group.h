@@ -15,6 +15,23 @@
 
 #include "face.h"
 #include "material.h"
+#include "../../logic/bounding_box.h"
+
+// Coarser version of a group's faces, packed after the full-detail faces in the same buffer
+struct GroupLod {
+    std::vector<std::shared_ptr<Face>> faces;
+    float error = 0.0f;     // largest world-space distance from the full-detail surface
+    int first = 0;          // vertex range in the group's buffer, filled by Obj3D::setup_buffers
+    int count = 0;
+};
+
+// Placement of a group inside the shared GeometryPool buffers
+struct PoolRange {
+    uint32_t first_vertex = 0;
+    uint32_t vertex_count = 0;
+    uint32_t first_index = 0;
+    uint32_t index_count = 0;      // 0 while the group is not pooled
+};
 
 class Group {
 public:
@@ -27,4 +44,14 @@ public:
     
     GLuint VAO;
     GLuint VBO;
+    GLuint instance_VBO = 0;    // per-instance matrices wired to this VAO, 0 if never instanced
+    size_t buffer_bytes = 0;    // size of VBO, for the GPU memory stat
+    PoolRange pool;
+
+    // Track chunks carry their own bounds for culling and only re-upload when dirty
+    BoundingBox bounds;
+    bool has_bounds = false;
+    bool dirty = true;
+    uint32_t content_hash = 0;
+    std::vector<GroupLod> lods;
 };
\ No newline at end of file
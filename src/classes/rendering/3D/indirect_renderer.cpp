@@ -0,0 +1,108 @@
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <iostream>
+
+#include "indirect_renderer.h"
+#include "../../logic/stats.h"
+
+void IndirectRenderer::init() {
+    if (indirect_buffer) return;
+    glGenBuffers(1, &indirect_buffer);
+
+    // glad is generated for GL 4.0, so the 4.3 entry point is looked up by hand
+    if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3)) {
+        multi_draw_elements_indirect = (MultiDrawElementsIndirectProc)glfwGetProcAddress("glMultiDrawElementsIndirect");
+    }
+    multi_draw = multi_draw_elements_indirect != nullptr;
+    std::cout << "Indirect submission: " << (multi_draw ? "glMultiDrawElementsIndirect" : "per-command fallback") << std::endl;
+}
+
+void IndirectRenderer::begin() {
+    draws.clear();
+    transforms.clear();
+    triangle_count = 0;
+}
+
+void IndirectRenderer::add(const Scene& scene, const std::vector<uint32_t>& entities, size_t first, size_t last) {
+    GLuint base_instance = transforms.size();
+    for (size_t i = first; i < last; i++) {
+        transforms.push_back(scene.transforms[entities[i]]);
+    }
+    const auto& source = scene.objects[entities[first]];
+    for (const auto& group : source->mesh->groups) {
+        if (group->pool.index_count == 0) continue;
+        Draw draw;
+        draw.source = source;
+        draw.group = group;
+        draw.command = {group->pool.index_count, (GLuint)(last - first), group->pool.first_index,
+                        (GLint)group->pool.first_vertex, base_instance};
+        draws.push_back(draw);
+        triangle_count += (size_t)(group->pool.index_count / 3) * (last - first);
+    }
+}
+
+void IndirectRenderer::submit(GeometryPool& pool, const MaterialBinder& bind_material) {
+    submit_calls = 0;
+    command_count = draws.size();
+    if (draws.empty()) return;
+
+    std::stable_sort(draws.begin(), draws.end(),
+                     [](const Draw& a, const Draw& b) { return a.group->material < b.group->material; });
+    commands.clear();
+    for (const auto& draw : draws) {
+        commands.push_back(draw.command);
+    }
+
+    pool.upload_draw_data(transforms);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+    if (commands.size() > indirect_capacity) {
+        indirect_capacity = std::max(commands.size(), indirect_capacity * 2);
+    }
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, indirect_capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data());
+
+    glBindVertexArray(pool.VAO);
+    Stats::add(Stats::STATE_CHANGES);
+    Stats::add(Stats::BUFFER_UPLOAD_BYTES, (int64_t)(commands.size() * sizeof(DrawElementsIndirectCommand)));
+    for (size_t begin = 0; begin < draws.size();) {
+        size_t end = begin + 1;
+        while (end < draws.size() && draws[end].group->material == draws[begin].group->material) {
+            end++;
+        }
+        bind_material(draws[begin].source, draws[begin].group);
+
+        if (multi_draw) {
+            multi_draw_elements_indirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                         (const void*)(begin * sizeof(DrawElementsIndirectCommand)),
+                                         (GLsizei)(end - begin), 0);
+            submit_calls++;
+        } else {
+            // Without base_instance support the matrix attributes are re-pointed per command
+            glBindBuffer(GL_ARRAY_BUFFER, pool.draw_VBO);
+            for (size_t i = begin; i < end; i++) {
+                const auto& command = commands[i];
+                for (GLuint column = 0; column < 4; column++) {
+                    glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                          (void*)(command.base_instance * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+                }
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                                                  (void*)(command.first_index * sizeof(GLuint)),
+                                                  command.instance_count, command.base_vertex);
+                submit_calls++;
+                Stats::add(Stats::STATE_CHANGES);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        begin = end;
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void IndirectRenderer::cleanup() {
+    if (indirect_buffer) {
+        glDeleteBuffers(1, &indirect_buffer);
+        indirect_buffer = 0;
+    }
+    indirect_capacity = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "geometry_pool.h"
+#include "scene.h"
+
+// Layout fixed by GL for glDrawElementsIndirect / glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+};
+
+// Builds one indirect command per (pooled mesh, group) each frame, with every
+// visible object of that mesh as an instance, and submits them from the
+// GeometryPool VAO. Commands are sorted by material so each material costs
+// one glMultiDrawElementsIndirect when the driver exposes it (GL 4.3); older
+// contexts replay the commands with glDrawElementsInstancedBaseVertex.
+class IndirectRenderer {
+public:
+    // Sets the material uniforms for a run of commands sharing group->material
+    using MaterialBinder = std::function<void(const std::shared_ptr<Obj3D>&, const std::shared_ptr<Group>&)>;
+
+    GLuint indirect_buffer = 0;
+    bool multi_draw = false;
+    int submit_calls = 0;       // GL draw calls issued by the last submit()
+    int command_count = 0;
+    size_t triangle_count = 0;  // queued since begin()
+
+    void init();
+    void begin();
+    // Queues the scene entities listed in entities[first, last), which share one pooled mesh
+    void add(const Scene& scene, const std::vector<uint32_t>& entities, size_t first, size_t last);
+    void submit(GeometryPool& pool, const MaterialBinder& bind_material);
+    void cleanup();
+
+private:
+    struct Draw {
+        std::shared_ptr<Obj3D> source;
+        std::shared_ptr<Group> group;
+        DrawElementsIndirectCommand command;
+    };
+    std::vector<Draw> draws;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<glm::mat4> transforms;
+    size_t indirect_capacity = 0;
+
+    typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+    MultiDrawElementsIndirectProc multi_draw_elements_indirect = nullptr;
+};
@@ -0,0 +1,48 @@
+#include "instance_buffer.h"
+#include "../../logic/stats.h"
+
+void InstanceBuffer::init() {
+    if (VBO) return;
+    glGenBuffers(1, &VBO);
+}
+
+void InstanceBuffer::upload(const std::vector<glm::mat4>& transforms) {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    if (transforms.size() > capacity) {
+        size_t grown = std::max(transforms.size(), capacity * 2);
+        Stats::add(Stats::GPU_BUFFER_BYTES, (int64_t)((grown - capacity) * sizeof(glm::mat4)));
+        capacity = grown;
+    }
+    // Orphan so the driver does not stall on the previous batch still reading it
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, transforms.size() * sizeof(glm::mat4), transforms.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    bytes_uploaded += transforms.size() * sizeof(glm::mat4);
+    Stats::add(Stats::BUFFER_UPLOAD_BYTES, (int64_t)(transforms.size() * sizeof(glm::mat4)));
+}
+
+void InstanceBuffer::attach(const std::shared_ptr<Group>& group) const {
+    if (group->instance_VBO == VBO) return;
+
+    glBindVertexArray(group->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    for (GLuint column = 0; column < 4; column++) {
+        GLuint location = FIRST_ATTRIBUTE + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    group->instance_VBO = VBO;
+}
+
+void InstanceBuffer::cleanup() {
+    if (VBO) {
+        glDeleteBuffers(1, &VBO);
+        VBO = 0;
+    }
+    Stats::add(Stats::GPU_BUFFER_BYTES, -(int64_t)(capacity * sizeof(glm::mat4)));
+    capacity = 0;
+}
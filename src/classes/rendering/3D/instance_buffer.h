@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+
+#include "group.h"
+
+// Per-instance model matrices for instanced draws. One buffer is shared by
+// every batch in a frame: upload() orphans and refills it before each batch,
+// and attach() wires it to a group's VAO as attributes 3-6 (divisor 1).
+class InstanceBuffer {
+public:
+    static const GLuint FIRST_ATTRIBUTE = 3;
+
+    GLuint VBO = 0;
+    size_t capacity = 0;            // matrices
+    size_t bytes_uploaded = 0;      // since the last reset_stats()
+
+    void init();
+    void upload(const std::vector<glm::mat4>& transforms);
+    void attach(const std::shared_ptr<Group>& group) const;
+    void reset_stats() { bytes_uploaded = 0; }
+    void cleanup();
+};
@@ -1,17 +1,9 @@
 #include "material.h"
+#include "render_device.h"
 #include <stb_image.h>
 
 void Material::cleanup() {
-    if (diffuse_texture) {
-        glDeleteTextures(1, &diffuse_texture);
-        diffuse_texture = 0;
-    }
-    if (specular_texture) {
-        glDeleteTextures(1, &specular_texture);
-        specular_texture = 0;
-    }
-    if (normal_texture) {
-        glDeleteTextures(1, &normal_texture);
-        normal_texture = 0;
-    }
+    RenderDevice::current().release_texture(diffuse_texture);
+    RenderDevice::current().release_texture(specular_texture);
+    RenderDevice::current().release_texture(normal_texture);
 }
@@ -8,21 +8,34 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <cfloat>
 
 #include "obj3d.h"
+#include "scene.h"
+#include "render_device.h"
 
 void Obj3D::update(float deltaTime) {
     if (is_animated && animation) {
         animation_time += deltaTime;
-        glm::vec3 newPos = animation->get_position_at_time(animation_time);
-        glm::vec3 nextPos = animation->get_position_at_time(animation_time + deltaTime);
-        glm::vec3 direction = nextPos - newPos;
-        direction = glm::normalize(direction);
-        float angle = atan2(direction.x, direction.z);
+        set_transform(animation_pose(animation->sample(animation_time, &animation_cursor)));
+    }
+}
 
+glm::mat4 Obj3D::animation_pose(const AnimationSample& sample) {
+    glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), sample.heading, glm::vec3(0.0f, 1.0f, 0.0f));
+    return glm::translate(glm::mat4(1.0f), sample.position) * rotation;
+}
 
-        glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f));
-        transform = glm::translate(glm::mat4(1.0f), newPos) * rotation;
+void Obj3D::set_transform(const glm::mat4& new_transform) {
+    transform = new_transform;
+    if (scene) {
+        scene->set_transform(scene->index_of(scene_handle), new_transform);
+    }
+}
+
+void Obj3D::sync() {
+    if (scene) {
+        scene->sync(scene->index_of(scene_handle));
     }
 }
 
@@ -50,12 +63,24 @@ void process_vertex_for_group(const glm::ivec3& indices,
 void Obj3D::setup_buffers(){
     if (buffers_created) return;
 
+    std::vector<float> interleaved_data;
     for (auto group : mesh->groups) {
-        std::vector<glm::vec3> group_verts;
-        std::vector<glm::vec2> group_mappings;
-        std::vector<glm::vec3> group_normals;
-        
-        for (const auto& face : group->faces) {
+        if (group->VAO && !group->dirty) continue;
+
+        int full_detail_count = build_group_vertices(*group, interleaved_data);
+        upload_group_buffers(group, interleaved_data.data(), interleaved_data.size() / 8);
+        group->vert_count = full_detail_count;
+    }
+    buffers_created = true;
+}
+
+int Obj3D::build_group_vertices(Group& group, std::vector<float>& interleaved_data) const {
+    std::vector<glm::vec3> group_verts;
+    std::vector<glm::vec2> group_mappings;
+    std::vector<glm::vec3> group_normals;
+    
+    auto append_faces = [&](const std::vector<std::shared_ptr<Face>>& faces) {
+        for (const auto& face : faces) {
             if (face->verts.size() > 3) {
                 for (size_t i = 1; i < face->verts.size() - 1; i++) {
                     process_vertex_for_group(glm::ivec3(face->verts[0], face->textures[0], face->normals[0]), 
@@ -76,72 +101,93 @@ void Obj3D::setup_buffers(){
                 }
             }
         }
-        
-        group->vert_count = group_verts.size();
-        
-        std::vector<float> interleaved_data;
-        for (size_t i = 0; i < group_verts.size(); i++) {
-            interleaved_data.push_back(group_verts[i].x);
-            interleaved_data.push_back(group_verts[i].y);
-            interleaved_data.push_back(group_verts[i].z);
-
-            if (i < group_mappings.size()) {
-                interleaved_data.push_back(group_mappings[i].x);
-                interleaved_data.push_back(group_mappings[i].y);
-            } else {
-                interleaved_data.push_back(0.0f);
-                interleaved_data.push_back(0.0f);
-            }
-
-            if (i < group_normals.size()) {
-                interleaved_data.push_back(group_normals[i].x);
-                interleaved_data.push_back(group_normals[i].y);
-                interleaved_data.push_back(group_normals[i].z);
-            } else {
-                interleaved_data.push_back(0.0f);
-                interleaved_data.push_back(1.0f);
-                interleaved_data.push_back(0.0f);
-            }
+    };
+
+    append_faces(group.faces);
+    int full_detail_count = group_verts.size();
+    for (auto& lod : group.lods) {
+        lod.first = group_verts.size();
+        append_faces(lod.faces);
+        lod.count = group_verts.size() - lod.first;
+    }
+    
+    interleaved_data.clear();
+    for (size_t i = 0; i < group_verts.size(); i++) {
+        interleaved_data.push_back(group_verts[i].x);
+        interleaved_data.push_back(group_verts[i].y);
+        interleaved_data.push_back(group_verts[i].z);
+
+        if (i < group_mappings.size()) {
+            interleaved_data.push_back(group_mappings[i].x);
+            interleaved_data.push_back(group_mappings[i].y);
+        } else {
+            interleaved_data.push_back(0.0f);
+            interleaved_data.push_back(0.0f);
         }
 
-        glGenVertexArrays(1, &group->VAO);
-        glGenBuffers(1, &group->VBO);
-
-        glBindVertexArray(group->VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, group->VBO);
-        glBufferData(GL_ARRAY_BUFFER, interleaved_data.size() * sizeof(float), 
-                     interleaved_data.data(), GL_STATIC_DRAW);
-
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 
-                             (void*)(3 * sizeof(float)));
-        
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 
-                             (void*)(5 * sizeof(float)));
-
-        glBindVertexArray(0);
+        if (i < group_normals.size()) {
+            interleaved_data.push_back(group_normals[i].x);
+            interleaved_data.push_back(group_normals[i].y);
+            interleaved_data.push_back(group_normals[i].z);
+        } else {
+            interleaved_data.push_back(0.0f);
+            interleaved_data.push_back(1.0f);
+            interleaved_data.push_back(0.0f);
+        }
     }
-    buffers_created = true;
+    return full_detail_count;
+}
+void Obj3D::upload_group_buffers(const std::shared_ptr<Group>& group, const float* interleaved_data, size_t vertex_count) {
+    group->vert_count = vertex_count;
+    group->dirty = false;
+    RenderDevice::current().upload_group(*group, interleaved_data, vertex_count);
 }
 
 void Obj3D::calculate_bbox(){
-    if (mesh->groups.empty()) return;
+    has_bounds = false;
+    world_bounds_valid = false;
+    if (!mesh || mesh->groups.empty()) {
+        sync();
+        return;
+    }
 
-    glm::vec3 min(FLT_MAX), max(FLT_MIN);
-    
-    for (const auto& pos : mesh->verts) {
-        min = glm::min(min, pos);
-        max = glm::max(max, pos);
+    glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+
+    // Chunked meshes already carry per-group bounds; avoid walking every vertex after each edit
+    bool grouped = std::all_of(mesh->groups.begin(), mesh->groups.end(),
+                               [](const std::shared_ptr<Group>& group) { return group->has_bounds; });
+    if (grouped) {
+        for (const auto& group : mesh->groups) {
+            min = glm::min(min, group->bounds.min);
+            max = glm::max(max, group->bounds.max);
+        }
+    } else {
+        for (const auto& pos : mesh->verts) {
+            min = glm::min(min, pos);
+            max = glm::max(max, pos);
+        }
     }
-    
+    if (min.x > max.x) {
+        sync();
+        return;
+    }
+
     bbox->min = min;
     bbox->max = max;
     bbox->center = (min + max) * 0.5f;
     bbox->size = max - min;
+    bbox->halfSize = bbox->size * 0.5f;
+    has_bounds = true;
+    sync();
+}
+
+const BoundingBox& Obj3D::get_world_bounds() {
+    if (!world_bounds_valid || transform != world_bounds_transform) {
+        world_bounds = bbox->transformed(transform);
+        world_bounds_transform = transform;
+        world_bounds_valid = true;
+    }
+    return world_bounds;
 }
 
 bool Obj3D::check_collision(const glm::vec3& point) const {
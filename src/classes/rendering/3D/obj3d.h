@@ -3,6 +3,9 @@
 #include "mesh.h"
 #include "animation.h"
 #include "../../logic/bounding_box.h"
+#include "../../logic/slot_map.h"
+
+class Scene;
 
 class Obj3D {
 public:
@@ -15,22 +18,43 @@ public:
     std::shared_ptr<Mesh> mesh;
     std::shared_ptr<Animation> animation;
     float animation_time = 0.0f;
+    size_t animation_cursor = 0;    // lookup hint for Animation::sample
     bool is_animated = false;
 
     bool selectable = false;
     bool eliminable;
     bool collidable;
     std::shared_ptr<BoundingBox> bbox;
+    bool has_bounds = false;        // bbox holds the mesh's local bounds
+
+    // bbox in world space, refreshed only when transform changes
+    BoundingBox world_bounds;
+    glm::mat4 world_bounds_transform;
+    bool world_bounds_valid = false;
+
+    // Set while the object is in a scene, which keeps copies of its state in component arrays
+    Scene* scene = nullptr;
+    SlotHandle scene_handle;
 
     Obj3D() : buffers_created(false), mesh(nullptr), transform(glm::mat4(1.0f)) {
         bbox = std::make_shared<BoundingBox>();
     }
     
     void setup_buffers();
+    // Triangulates a group (full detail, then its LODs) into position(3)/uv(2)/normal(3)
+    // vertices and fills the LOD ranges; returns the full-detail vertex count.
+    int build_group_vertices(Group& group, std::vector<float>& interleaved_data) const;
+    // Uploads position(3)/uv(2)/normal(3) interleaved vertices into the group's VAO.
+    static void upload_group_buffers(const std::shared_ptr<Group>& group, const float* interleaved_data, size_t vertex_count);
     void update(float deltaTime);
+    static glm::mat4 animation_pose(const AnimationSample& sample);
+    // Changes made after the object joined a scene go through these
+    void set_transform(const glm::mat4& new_transform);
+    void sync();    // after changing the mesh, bounds, flags or animation
     void set_animation(std::shared_ptr<Animation> anim) { 
         animation = anim; 
         is_animated = (anim != nullptr);};
     void calculate_bbox();
+    const BoundingBox& get_world_bounds();
     bool check_collision(const glm::vec3& point) const;
 };
@@ -0,0 +1,139 @@
+#include "render_device.h"
+#include "../../logic/stats.h"
+
+static std::unique_ptr<RenderDevice> current_device;
+
+RenderDevice& RenderDevice::current() {
+    if (!current_device) {
+        current_device = std::make_unique<GLRenderDevice>();
+    }
+    return *current_device;
+}
+
+void RenderDevice::set_current(std::unique_ptr<RenderDevice> device) {
+    current_device = std::move(device);
+}
+
+// Keeps the buffer byte stats in step with what a group holds on the device
+static void track_group_bytes(Group& group, size_t bytes) {
+    Stats::add(Stats::BUFFER_UPLOAD_BYTES, (int64_t)bytes);
+    Stats::add(Stats::GPU_BUFFER_BYTES, (int64_t)bytes - (int64_t)group.buffer_bytes);
+    group.buffer_bytes = bytes;
+}
+
+static void untrack_group_bytes(Group& group) {
+    Stats::add(Stats::GPU_BUFFER_BYTES, -(int64_t)group.buffer_bytes);
+    group.buffer_bytes = 0;
+}
+
+void GLRenderDevice::upload_group(Group& group, const float* interleaved_data, size_t vertex_count) {
+    bytes_uploaded += vertex_count * 8 * sizeof(float);
+    groups_uploaded++;
+    track_group_bytes(group, vertex_count * 8 * sizeof(float));
+
+    if (group.VAO) {
+        // Existing chunk: replace the data, the attribute layout is unchanged
+        glBindBuffer(GL_ARRAY_BUFFER, group.VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertex_count * 8 * sizeof(float), 
+                     interleaved_data, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+
+    glGenVertexArrays(1, &group.VAO);
+    glGenBuffers(1, &group.VBO);
+
+    glBindVertexArray(group.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, group.VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertex_count * 8 * sizeof(float), 
+                 interleaved_data, GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 
+                         (void*)(3 * sizeof(float)));
+    
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 
+                         (void*)(5 * sizeof(float)));
+
+    glBindVertexArray(0);
+}
+
+void GLRenderDevice::release_group(Group& group) {
+    untrack_group_bytes(group);
+    if (group.VAO) {
+        glDeleteVertexArrays(1, &group.VAO);
+        group.VAO = 0;
+    }
+    if (group.VBO) {
+        glDeleteBuffers(1, &group.VBO);
+        group.VBO = 0;
+    }
+}
+
+unsigned int GLRenderDevice::create_texture(const TextureImage& image) {
+    if (!image.valid()) return 0;
+
+    GLenum format = GL_RGB;
+    if (image.channels == 1)
+        format = GL_RED;
+    else if (image.channels == 4)
+        format = GL_RGBA;
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels.get());
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    bytes_uploaded += image.bytes();
+    // The mip chain adds about a third on top of the base level
+    Stats::texture_created(texture, image.bytes() * 4 / 3);
+    Stats::add(Stats::BUFFER_UPLOAD_BYTES, (int64_t)image.bytes());
+    return texture;
+}
+
+void GLRenderDevice::release_texture(unsigned int& texture) {
+    if (texture) {
+        Stats::texture_released(texture);
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+}
+
+void NullRenderDevice::upload_group(Group& group, const float*, size_t vertex_count) {
+    bytes_uploaded += vertex_count * 8 * sizeof(float);
+    groups_uploaded++;
+    track_group_bytes(group, vertex_count * 8 * sizeof(float));
+    if (!group.VAO) {
+        group.VAO = next_handle++;
+        group.VBO = next_handle++;
+    }
+}
+
+void NullRenderDevice::release_group(Group& group) {
+    untrack_group_bytes(group);
+    group.VAO = 0;
+    group.VBO = 0;
+}
+
+unsigned int NullRenderDevice::create_texture(const TextureImage& image) {
+    if (!image.valid()) return 0;
+    bytes_uploaded += image.bytes();
+    unsigned int texture = next_handle++;
+    Stats::texture_created(texture, image.bytes() * 4 / 3);
+    return texture;
+}
+
+void NullRenderDevice::release_texture(unsigned int& texture) {
+    Stats::texture_released(texture);
+    texture = 0;
+}
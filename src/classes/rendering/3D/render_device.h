@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <memory>
+#include <string>
+
+#include "group.h"
+#include "texture_image.h"
+
+// The GL resource calls made while loading and building geometry. Scene,
+// Obj3D and Material go through the current device instead of calling GL
+// directly, so the simulation can run with NullRenderDevice and no context.
+// GeometryPool and IndirectRenderer are the exception: they only exist in the
+// windowed viewer, which packs meshes into the pool from on_object_loaded on
+// the context thread, and they call GL themselves.
+class RenderDevice {
+public:
+    size_t bytes_uploaded = 0;
+    size_t groups_uploaded = 0;
+
+    virtual ~RenderDevice() = default;
+    virtual const char* name() const = 0;
+    // Creates the group's VAO/VBO on first use, otherwise replaces the buffer contents
+    virtual void upload_group(Group& group, const float* interleaved_data, size_t vertex_count) = 0;
+    virtual void release_group(Group& group) = 0;
+    // Uploads a decoded image with mipmaps; returns 0 if the image is empty
+    virtual unsigned int create_texture(const TextureImage& image) = 0;
+    virtual void release_texture(unsigned int& texture) = 0;
+
+    static RenderDevice& current();
+    static void set_current(std::unique_ptr<RenderDevice> device);
+};
+
+class GLRenderDevice : public RenderDevice {
+public:
+    const char* name() const override { return "gl"; }
+    void upload_group(Group& group, const float* interleaved_data, size_t vertex_count) override;
+    void release_group(Group& group) override;
+    unsigned int create_texture(const TextureImage& image) override;
+    void release_texture(unsigned int& texture) override;
+};
+
+// Counts uploads and hands out fake handles so dirty tracking behaves as with GL
+class NullRenderDevice : public RenderDevice {
+public:
+    const char* name() const override { return "null"; }
+    void upload_group(Group& group, const float* interleaved_data, size_t vertex_count) override;
+    void release_group(Group& group) override;
+    unsigned int create_texture(const TextureImage& image) override;
+    void release_texture(unsigned int& texture) override;
+
+private:
+    GLuint next_handle = 1;
+};
@@ -9,21 +9,178 @@
 #include <string>
 
 #include "scene.h"
+#include "render_device.h"
+
+SlotHandle Scene::add_object(std::shared_ptr<Obj3D> object){
+    SlotHandle handle = entities.insert();
+    object->scene = this;
+    object->scene_handle = handle;
 
-void Scene::add_object(std::shared_ptr<Obj3D> object){
     objects.push_back(object);
+    transforms.emplace_back(1.0f);
+    local_bounds.emplace_back();
+    world_bounds.emplace_back();
+    meshes.push_back(nullptr);
+    flags.push_back(0);
+    animations.emplace_back();
+    nodes.push_back(TransformHierarchy::NONE);
+    sync((uint32_t)objects.size() - 1);
+    return handle;
+}
+
+void Scene::remove_object(SlotHandle handle) {
+    uint32_t index = entities.erase(handle);
+    if (index == INVALID_INDEX) return;
+    objects[index]->scene = nullptr;
+    if (nodes[index] != TransformHierarchy::NONE) {
+        node_entities[nodes[index]] = SlotHandle();
+        hierarchy.remove_node(nodes[index]);
+    }
+
+    size_t last = objects.size() - 1;
+    if (index != last) {
+        objects[index] = std::move(objects[last]);
+        transforms[index] = transforms[last];
+        local_bounds[index] = local_bounds[last];
+        world_bounds[index] = world_bounds[last];
+        meshes[index] = meshes[last];
+        flags[index] = flags[last];
+        animations[index] = animations[last];
+        nodes[index] = nodes[last];
+    }
+    objects.pop_back();
+    transforms.pop_back();
+    local_bounds.pop_back();
+    world_bounds.pop_back();
+    meshes.pop_back();
+    flags.pop_back();
+    animations.pop_back();
+    nodes.pop_back();
+}
+
+void Scene::eliminate(uint32_t index) {
+    if (index >= objects.size() || !(flags[index] & ACTIVE)) return;
+    flags[index] &= ~(ACTIVE | COLLIDABLE);
+    objects[index]->active = false;
+    objects[index]->collidable = false;
+    eliminated.push_back(entities.handle_at(index));
+}
+
+void Scene::set_transform(uint32_t index, const glm::mat4& transform) {
+    if (index >= objects.size()) return;
+    transforms[index] = transform;
+    flags[index] |= BOUNDS_DIRTY;
+    if (nodes[index] != TransformHierarchy::NONE) {
+        hierarchy.set_world(nodes[index], transform);
+    }
 }
-void Scene::remove_object(int index) { 
-    if (index >= 0 && index < objects.size()) {
-        objects.erase(objects.begin() + index);
+
+void Scene::sync(uint32_t index) {
+    if (index >= objects.size()) return;
+    const Obj3D& obj = *objects[index];
+    transforms[index] = obj.transform;
+    if (nodes[index] != TransformHierarchy::NONE) {
+        hierarchy.set_world(nodes[index], obj.transform);
+    }
+    local_bounds[index] = {obj.bbox->min, obj.bbox->max};
+    meshes[index] = obj.mesh.get();
+
+    if (!obj.active && (flags[index] & ACTIVE)) {
+        eliminated.push_back(entities.handle_at(index));
+    }
+
+    uint8_t f = BOUNDS_DIRTY;
+    if (obj.active) f |= ACTIVE;
+    if (obj.collidable) f |= COLLIDABLE;
+    if (obj.eliminable) f |= ELIMINABLE;
+    if (obj.selectable) f |= SELECTABLE;
+    if (obj.has_bounds) f |= HAS_BOUNDS;
+    if (obj.is_animated && obj.animation) f |= ANIMATED;
+    flags[index] = f;
+
+    // A new animation starts from the object's own time; otherwise the scene's copy is ahead
+    AnimationState& state = animations[index];
+    if (state.animation != obj.animation.get()) {
+        state = {obj.animation.get(), obj.animation_time, obj.animation_cursor};
+    }
+}
+
+void Scene::animate(float deltaTime) {
+    for (size_t i = 0; i < flags.size(); i++) {
+        if (!(flags[i] & ANIMATED)) continue;
+        AnimationState& state = animations[i];
+        state.time += deltaTime;
+        set_transform((uint32_t)i, Obj3D::animation_pose(state.animation->sample(state.time, &state.cursor)));
+
+        Obj3D& obj = *objects[i];
+        obj.transform = transforms[i];
+        obj.animation_time = state.time;
+        obj.animation_cursor = state.cursor;
     }
 }
+
+uint32_t Scene::node_of(SlotHandle handle) {
+    uint32_t index = index_of(handle);
+    if (index == INVALID_INDEX) return TransformHierarchy::NONE;
+    if (nodes[index] == TransformHierarchy::NONE) {
+        uint32_t node = hierarchy.add_node(transforms[index]);
+        if (node >= node_entities.size()) node_entities.resize(node + 1);
+        node_entities[node] = handle;
+        nodes[index] = node;
+    }
+    return nodes[index];
+}
+
+bool Scene::attach(SlotHandle child, SlotHandle parent, const glm::mat4& local) {
+    uint32_t index = index_of(child);
+    if (index == INVALID_INDEX || !entities.contains(parent)) return false;
+    uint32_t node = node_of(child);
+    if (!hierarchy.set_parent(node, node_of(parent))) {
+        std::cerr << "Cannot attach " << objects[index]->name << ": it would become its own ancestor" << std::endl;
+        return false;
+    }
+    hierarchy.set_local(node, local);
+    transforms[index] = objects[index]->transform = hierarchy.current_world(node);
+    flags[index] |= BOUNDS_DIRTY;
+    return true;
+}
+
+void Scene::detach(SlotHandle child) {
+    uint32_t index = index_of(child);
+    if (index == INVALID_INDEX || nodes[index] == TransformHierarchy::NONE) return;
+    hierarchy.set_parent(nodes[index], TransformHierarchy::NONE);
+}
+
+void Scene::update_hierarchy(unsigned threads) {
+    if (hierarchy.update(threads) == 0) return;
+    for (uint32_t node : hierarchy.changed_nodes) {
+        if (node >= node_entities.size()) continue;
+        uint32_t index = index_of(node_entities[node]);
+        if (index == INVALID_INDEX) continue;
+        transforms[index] = objects[index]->transform = hierarchy.worlds[node];
+        flags[index] |= BOUNDS_DIRTY;
+    }
+}
+
+void Scene::update_bounds() {
+    for (size_t i = 0; i < flags.size(); i++) {
+        if (!(flags[i] & BOUNDS_DIRTY)) continue;
+        BoundingBox local;
+        local.min = local_bounds[i].min;
+        local.max = local_bounds[i].max;
+        BoundingBox world = local.transformed(transforms[i]);
+        world_bounds[i] = {world.min, world.max};
+        flags[i] &= ~BOUNDS_DIRTY;
+    }
+}
+
 void Scene::update(){
-    objects.erase(
-    std::remove_if(objects.begin(), objects.end(),
-        [](const std::shared_ptr<Obj3D>& obj) { return !obj->active;}),
-    objects.end());
+    for (SlotHandle handle : eliminated) {
+        remove_object(handle);
+    }
+    eliminated.clear();
 }
+
 void Scene::cleanup() {
     for (auto obj : objects) {
         if (obj && obj->mesh) {
@@ -32,17 +189,22 @@ void Scene::cleanup() {
                     if (group->material) {
                         group->material->cleanup();
                     }
-                    if (group->VAO) {
-                        glDeleteVertexArrays(1, &group->VAO);
-                        group->VAO = 0;
-                    }
-                    if (group->VBO) {
-                        glDeleteBuffers(1, &group->VBO);
-                        group->VBO = 0;
-                    }
+                    RenderDevice::current().release_group(*group);
                 }
             }
         }
+        if (obj) obj->scene = nullptr;
     }
     objects.clear();
-}
\ No newline at end of file
+    transforms.clear();
+    local_bounds.clear();
+    world_bounds.clear();
+    meshes.clear();
+    flags.clear();
+    animations.clear();
+    nodes.clear();
+    hierarchy.clear();
+    node_entities.clear();
+    entities.clear();
+    eliminated.clear();
+}
@@ -1,20 +1,96 @@
 #pragma once
 
+#include <cstdint>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "obj3d.h"
+#include "../../logic/slot_map.h"
+#include "../../logic/transform_hierarchy.h"
 
+// Entity store. `objects` owns the Obj3Ds; the component arrays next to it hold
+// what the per-frame passes read, densely and in the same order (entry i of
+// every array belongs to objects[i]), so those passes walk flat arrays instead
+// of chasing shared_ptrs. Objects write their changes through
+// Obj3D::set_transform and Obj3D::sync.
+//
+// Handles returned by add_object stay valid while entries move and turn
+// invalid once the object is removed; index_of() maps them to the current
+// position. Removal moves the last entity into the hole, so it is O(1) but
+// does not keep the order. A frame runs the stages in array order:
+//   animate(dt)        objects with their own animation -> transforms
+//   update_hierarchy() attached objects follow their parents -> transforms
+//   update_bounds()    changed transforms -> world_bounds
+//   collisions / culling read world_bounds and flags; eliminate() only marks
+//   update()           removes the entities eliminated this frame, if any
 class Scene{
 public:
+    enum Flags : uint8_t {
+        ACTIVE = 1 << 0,
+        COLLIDABLE = 1 << 1,
+        ELIMINABLE = 1 << 2,
+        SELECTABLE = 1 << 3,
+        HAS_BOUNDS = 1 << 4,        // local_bounds hold the mesh's bounds
+        ANIMATED = 1 << 5,
+        BOUNDS_DIRTY = 1 << 6,      // world_bounds are behind the transform
+    };
+
+    struct Aabb {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    struct AnimationState {
+        Animation* animation = nullptr;
+        float time = 0.0f;
+        size_t cursor = 0;
+    };
+
+    static const uint32_t INVALID_INDEX = SlotMap::INVALID_INDEX;
+
     std::vector<std::shared_ptr<Obj3D>> objects;
+    std::vector<glm::mat4> transforms;
+    std::vector<Aabb> local_bounds;
+    std::vector<Aabb> world_bounds;
+    std::vector<Mesh*> meshes;                  // render handle, null until the mesh is loaded
+    std::vector<uint8_t> flags;
+    std::vector<AnimationState> animations;
+    std::vector<uint32_t> nodes;                // hierarchy node, NONE while not attached
 
-    void add_object(std::shared_ptr<Obj3D> object);
-    void remove_object(int index);
-    
+    // Parent/child links between entities, plus free nodes such as cameras. An
+    // attached entity's transform is the node's world matrix; set_transform on
+    // it moves the node, keeping it attached.
+    TransformHierarchy hierarchy;
+
+    SlotHandle add_object(std::shared_ptr<Obj3D> object);
+    void remove_object(SlotHandle handle);
+    // Deactivates the entity now and removes it in the next update()
+    void eliminate(uint32_t index);
+    uint32_t index_of(SlotHandle handle) const { return entities.index_of(handle); }
+    SlotHandle handle_at(uint32_t index) const { return entities.handle_at(index); }
+    bool contains(const Obj3D& object) const { return object.scene == this && entities.contains(object.scene_handle); }
+    // Hierarchy node following the entity, created on first use
+    uint32_t node_of(SlotHandle handle);
+    // child's transform becomes `local` relative to parent; fails on cycles
+    bool attach(SlotHandle child, SlotHandle parent, const glm::mat4& local);
+    void detach(SlotHandle child);
+    size_t size() const { return objects.size(); }
+
+    // Component writes, normally reached through the Obj3D
+    void set_transform(uint32_t index, const glm::mat4& transform);
+    void sync(uint32_t index);
+
+    void animate(float deltaTime);
+    void update_hierarchy(unsigned threads = 1);
+    void update_bounds();
     void update();
 
     void cleanup();
+
+private:
+    SlotMap entities;
+    std::vector<SlotHandle> eliminated;
+    std::vector<SlotHandle> node_entities;      // hierarchy node -> entity
 };
@@ -0,0 +1,16 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "texture_image.h"
+
+void TextureImage::PixelDeleter::operator()(unsigned char* pixels) const {
+    stbi_image_free(pixels);
+}
+
+bool TextureImage::load(const std::string& filename) {
+    path = filename;
+    // The flip flag is per thread so concurrent loaders do not race on it
+    stbi_set_flip_vertically_on_load_thread(true);
+    pixels.reset(stbi_load(filename.c_str(), &width, &height, &channels, 0));
+    return valid();
+}
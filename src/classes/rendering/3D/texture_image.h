@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+// Decoded image ready for upload, rows flipped for GL. Decoding touches no GL
+// state, so it can run on loader threads; RenderDevice::create_texture does
+// the upload on the context thread.
+struct TextureImage {
+    struct PixelDeleter {
+        void operator()(unsigned char* pixels) const;
+    };
+
+    std::string path;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::unique_ptr<unsigned char, PixelDeleter> pixels;
+
+    bool load(const std::string& filename);
+    bool valid() const { return pixels != nullptr; }
+    size_t bytes() const { return (size_t)width * height * channels; }
+};
@@ -9,20 +9,42 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <cfloat>
+#include <unordered_map>
 
 #include "classes/logic/track_editor.h"
 #include "classes/rendering/3D/scene.h"
 #include "classes/logic/obj3dwriter.h"
 #include "classes/logic/bullet_manager.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include "classes/logic/track_exporter.h"
+#include "classes/logic/track_history.h"
+#include "classes/logic/track_document.h"
+#include "classes/logic/frustum.h"
+#include "classes/logic/animation_system.h"
+#include "classes/rendering/2D/track_overlay.h"
+#include "classes/rendering/3D/instance_buffer.h"
+#include "classes/rendering/3D/indirect_renderer.h"
+#include "classes/rendering/3D/gpu_timer.h"
+#include "classes/logic/profiler.h"
+#include "classes/logic/stats.h"
+#include "classes/logic/input_log.h"
+#include "classes/logic/scene_loader.h"
+#include "classes/logic/scene_manifest.h"
+#include "classes/rendering/3D/render_device.h"
 
 using namespace std;
 namespace fs = std::filesystem;
 
 const GLuint WIDTH = 1200, HEIGHT = 800;
 
+// Scene to load (--scene <file>); falls back to the legacy config.cfg when missing
+std::string scene_file = "../objs/scene.rscene";
+const std::string LEGACY_CONFIG_FILE = "../objs/config.cfg";
+SceneManifest scene_manifest;
+
 glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 20.0f);
 glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
 glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
@@ -48,8 +70,10 @@ const GLchar* vertexShaderSource = R"glsl(
     layout (location = 0) in vec3 position;
     layout (location = 1) in vec2 texCoord;
     layout (location = 2) in vec3 normal;
+    layout (location = 3) in mat4 instanceModel;
     
     uniform mat4 model;
+    uniform bool useInstancing;
     uniform mat4 view;
     uniform mat4 projection;
     
@@ -59,9 +83,10 @@ const GLchar* vertexShaderSource = R"glsl(
     
     void main()
     {
-        FragPos = vec3(model * vec4(position, 1.0));
+        mat4 world = useInstancing ? instanceModel : model;
+        FragPos = vec3(world * vec4(position, 1.0));
         TexCoord = texCoord;
-        Normal = mat3(transpose(inverse(model))) * normal;
+        Normal = mat3(transpose(inverse(world))) * normal;
         gl_Position = projection * view * vec4(FragPos, 1.0);
     }
 )glsl";
@@ -138,19 +163,115 @@ const GLchar* fragmentShaderSource = R"glsl(
 
 std::unique_ptr<Scene> current_scene = std::make_unique<Scene>();
 std::unique_ptr<BulletManager> bullet_manager = std::make_unique<BulletManager>();
-int currentObjectIndex;
+SlotHandle selected_handle;     // object moved by the arrow keys, cycled with Page Up/Down
+
+// V in the model viewer rides along with the car: a hierarchy node under the
+// car at this offset (car space, +z forward) drives the camera
+uint32_t chase_camera_node = TransformHierarchy::NONE;
+const glm::vec3 CHASE_CAMERA_OFFSET(0.0f, 2.5f, -6.0f);
 
 std::unique_ptr<TrackEditor> trackEditor = std::make_unique<TrackEditor>();
+std::unique_ptr<TrackExporter> track_exporter = std::make_unique<TrackExporter>();
+std::unique_ptr<TrackHistory> track_history = std::make_unique<TrackHistory>();
+std::unique_ptr<AnimationSystem> animation_system = std::make_unique<AnimationSystem>();
+bool reload_track_after_export = false;
 std::shared_ptr<Obj3D> current_track = std::make_shared<Obj3D>();
 std::shared_ptr<Obj3D> loaded_track = std::make_shared<Obj3D>();
 std::shared_ptr<Obj3D> racecar = std::make_shared<Obj3D>();
 
+// Track chunks drawn / skipped by frustum culling in the last frame
+int chunks_visible = 0;
+int chunks_culled = 0;
+size_t triangles_drawn = 0;
+
+// Scene entities kept / skipped by the per-object frustum test and its CPU cost in the last frame
+std::vector<uint32_t> visible_entities;
+int objects_visible = 0;
+int objects_culled = 0;
+double cull_ms = 0.0;
+
+// Visible objects sharing a mesh are drawn with one instanced call per group
+InstanceBuffer instance_buffer;
+const size_t MIN_INSTANCES = 2;
+int draw_calls = 0;
+int instanced_batches = 0;
+
+// Static props live in one shared vertex/index pool and are submitted as indirect commands
+GeometryPool geometry_pool;
+IndirectRenderer indirect_renderer;
+bool use_indirect = true;
+
+// Frame profiler output (scopes only record when built with -DRACETRACK_PROFILE)
+GpuTimer gpu_timer;
+const std::string PROFILE_TRACE_FILE = "../profile_trace.json";
+
+// Per-frame counters dump, enabled with --stats <file.csv|file.json> [--stats-interval frames]
+std::string stats_file;
+int stats_interval = 60;
+
+// Input session capture/replay (--record <file.rtin>, --replay <file.rtin> [--headless]).
+// Keys held down are tracked from the key events, so replayed and live runs
+// see the same state in processInput.
+InputRecorder input_recorder;
+InputPlayer input_player;
+std::string record_file;
+std::string replay_file;
+bool headless = false;
+uint32_t simulation_seed = 1234;
+bool held_keys[GLFW_KEY_LAST + 1] = {};
+
+// The car and config.cfg props load in the background while the editor runs;
+// each frame uploads finished files for at most LOAD_BUDGET_MS
+SceneLoader scene_loader;
+const double LOAD_BUDGET_MS = 4.0;
+const std::string WINDOW_TITLE = "Racetrack Editor";
+std::chrono::steady_clock::time_point program_start;
+
+// Props from config.cfg, used to scatter the culling benchmark field
+std::vector<std::shared_ptr<Obj3D>> scene_props;
+const size_t PROP_FIELD_SIZE = 10000;
+
+// Largest on-screen error, in pixels, accepted when picking a coarser track LOD
+float lod_pixel_error = 1.0f;
+
+// Control point picking in the track editor
+const float PICK_RADIUS_PIXELS = 10.0f;
+int hovered_point = -1;
+int selected_point = -1;
+bool dragging_point = false;
+bool track_preview_dirty = false;   // regenerate the preview once per frame while dragging
+
 // 0 = track editor / 1 = 3D model viewer
 int current_mode = 0;
 
 int selected_object = 0;
 
-static GLuint pointShader = 0;
+TrackOverlay track_overlay;
+
+glm::mat4 camera_view() {
+    return glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+}
+
+glm::mat4 camera_projection() {
+    return glm::perspective(glm::radians(fov), (float)WIDTH / HEIGHT, 0.1f, 100.0f);
+}
+
+// Coarsest level of detail whose geometric error projects to at most lod_pixel_error
+// pixels at the closest point of the chunk; -1 selects the full-detail faces.
+int select_lod(const Group& group, const BoundingBox& world_bounds) {
+    if (group.lods.empty()) return -1;
+
+    glm::vec3 closest = glm::max(world_bounds.min, glm::min(cameraPos, world_bounds.max));
+    float distance = glm::length(closest - cameraPos);
+    float pixels_per_unit = HEIGHT / (2.0f * tan(glm::radians(fov) * 0.5f));
+
+    int level = -1;
+    for (size_t l = 0; l < group.lods.size(); l++) {
+        if (group.lods[l].error * pixels_per_unit > lod_pixel_error * distance) break;
+        level = l;
+    }
+    return level;
+}
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
@@ -185,7 +306,7 @@ void first_person(double xpos, double ypos){
 }
 
 void update_track_preview() {
-    if (std::find(current_scene->objects.begin(), current_scene->objects.end(), current_track) == current_scene->objects.end()) {
+    if (!current_scene->contains(*current_track)) {
         current_track->name = "Track";
         current_scene->add_object(current_track);
         std::cout << "Added track to scene" << std::endl;
@@ -197,56 +318,174 @@ void update_track_preview() {
     current_track->buffers_created = false;
     current_track->obj_file = "../objs/track/...";
     current_track->setup_buffers();
+    current_track->calculate_bbox();
 
-    auto it = std::find(current_scene->objects.begin(), current_scene->objects.end(), current_track);
-    if (it == current_scene->objects.end()) {
+    if (!current_scene->contains(*current_track)) {
         current_scene->add_object(current_track);
         std::cout << "Added track to scene" << std::endl;
     }
 }
 
+void adjust_selected_control_point(float width, float bank, float elevation) {
+    if (trackEditor->control_points.empty()) return;
+    size_t index = trackEditor->control_points.size() - 1;
+    if (selected_point >= 0 && selected_point < (int)trackEditor->control_points.size()) {
+        index = selected_point;
+    }
+    TrackPointAttributes attributes = trackEditor->point_attributes[index];
+    attributes.width = std::max(0.1f, attributes.width + width);
+    attributes.bank += bank;
+    attributes.elevation += elevation;
+    track_history->set_attributes(*trackEditor, index, attributes);
+    std::cout << "Control point " << index << ": width " << attributes.width << ", bank "
+              << glm::degrees(attributes.bank) << " deg, elevation " << attributes.elevation << std::endl;
+    if (trackEditor->control_points.size() >= 4) {
+        update_track_preview();
+    }
+}
+
+void cycle_track_profile() {
+    static int profile_index = 0;
+    profile_index = (profile_index + 1) % 3;
+    if (profile_index == 0) trackEditor->profile = TrackProfile::flat();
+    else if (profile_index == 1) trackEditor->profile = TrackProfile::kerbs();
+    else trackEditor->profile = TrackProfile::circuit();
+    std::cout << "Track profile: " << trackEditor->profile.size() << " vertices" << std::endl;
+    if (trackEditor->control_points.size() >= 4) {
+        update_track_preview();
+    }
+}
+
+// Cursor ray intersected with the horizontal plane y = height, in track editor (x, z) coordinates
+bool cursor_ground_point(double xpos, double ypos, glm::vec2& ground, float height = 0.0f) {
+    float ndcX = (2.0f * xpos) / WIDTH - 1.0f;
+    float ndcY = 1.0f - (2.0f * ypos) / HEIGHT;
+    
+    glm::vec4 rayClip = glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    
+    glm::mat4 projection = camera_projection();
+    glm::mat4 view = camera_view();
+    
+    glm::mat4 invProjection = glm::inverse(projection);
+    glm::vec4 rayEye = invProjection * rayClip;
+    rayEye = glm::vec4(rayEye.x, rayEye.y, -1.0f, 0.0f);
+    
+    glm::mat4 invView = glm::inverse(view);
+    glm::vec4 rayWorld = invView * rayEye;
+    glm::vec3 rayDir = glm::normalize(glm::vec3(rayWorld));
+    
+    if (fabs(rayDir.y) <= 0.0001f) return false;
+    float t = (height - cameraPos.y) / rayDir.y;
+    if (t < 0.0f) return false;
+    glm::vec3 worldPos = cameraPos + t * rayDir;
+    ground = glm::vec2(worldPos.x, worldPos.z);
+    return true;
+}
+
+// World distance covered by PICK_RADIUS_PIXELS at a point on the plane y = height
+float pick_radius(const glm::vec2& ground, float height = 0.0f) {
+    float distance = glm::length(glm::vec3(ground.x, height, ground.y) - cameraPos);
+    float units_per_pixel = 2.0f * tan(glm::radians(fov) * 0.5f) * distance / HEIGHT;
+    return PICK_RADIUS_PIXELS * units_per_pixel;
+}
+
+// Control point under the cursor, or -1. Points are drawn at their elevation, so
+// the cursor ray is cut with one plane per elevation in use and each plane only
+// picks the points that sit on it; the closest hit relative to its pick radius wins.
+int pick_control_point(double xpos, double ypos) {
+    int best = -1;
+    float best_ratio = FLT_MAX;
+    for (float elevation : trackEditor->elevation_levels()) {
+        glm::vec2 hit;
+        if (!cursor_ground_point(xpos, ypos, hit, elevation)) continue;
+        float radius = pick_radius(hit, elevation);
+        int picked = trackEditor->nearest_control_point(hit, radius, elevation);
+        if (picked < 0) continue;
+        float ratio = glm::length(trackEditor->control_points[picked] - hit) / radius;
+        if (ratio < best_ratio) {
+            best_ratio = ratio;
+            best = picked;
+        }
+    }
+    return best;
+}
+
 void track_editor(double xpos, double ypos) {
-    static double lastClickX = 0, lastClickY = 0;
-    lastClickX = xpos;
-    lastClickY = ypos;
+    if (dragging_point && selected_point >= 0) {
+        // Drag in the point's own plane so it stays under the cursor
+        glm::vec2 target;
+        float elevation = trackEditor->point_attributes[selected_point].elevation;
+        if (!cursor_ground_point(xpos, ypos, target, elevation)) return;
+        track_history->move_point(*trackEditor, selected_point, target);
+        track_preview_dirty = true;
+        return;
+    }
+    hovered_point = pick_control_point(xpos, ypos);
 }
 
-void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
-    if (current_mode == 0 && button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-        double xpos, ypos;
-        glfwGetCursorPos(window, &xpos, &ypos);
-        
-        float ndcX = (2.0f * xpos) / WIDTH - 1.0f;
-        float ndcY = 1.0f - (2.0f * ypos) / HEIGHT;
-        
-        glm::vec4 rayClip = glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
-        
-        glm::mat4 projection = glm::perspective(glm::radians(fov), (float)WIDTH / HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-        
-        glm::mat4 invProjection = glm::inverse(projection);
-        glm::vec4 rayEye = invProjection * rayClip;
-        rayEye = glm::vec4(rayEye.x, rayEye.y, -1.0f, 0.0f);
-        
-        glm::mat4 invView = glm::inverse(view);
-        glm::vec4 rayWorld = invView * rayEye;
-        glm::vec3 rayDir = glm::normalize(glm::vec3(rayWorld));
+void remove_selected_control_point() {
+    if (selected_point < 0 || selected_point >= (int)trackEditor->control_points.size()) return;
+    track_history->remove_point(*trackEditor, selected_point);
+    std::cout << "Removed control point " << selected_point << std::endl;
+    selected_point = -1;
+    hovered_point = -1;
+    dragging_point = false;
+    update_track_preview();
+}
+
+void handle_mouse_button(int button, int action, int mods, double xpos, double ypos) {
+    if (current_mode != 0) return;
+
+    glm::vec2 ground;
+    bool on_ground = cursor_ground_point(xpos, ypos, ground);
+
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+        int picked = pick_control_point(xpos, ypos);
+        if (picked >= 0) {
+            selected_point = picked;
+            dragging_point = true;
+            track_history->begin_merge();
+            return;
+        }
+
+        if (!on_ground) return;
+        float radius = pick_radius(ground);
+
+        // Shift-click next to the track splits the segment under the cursor
+        int insert_at = (mods & GLFW_MOD_SHIFT) ? trackEditor->nearest_segment(ground, radius * 3.0f) : -1;
+        if (insert_at >= 0) {
+            track_history->insert_point(*trackEditor, insert_at, ground);
+            selected_point = insert_at;
+            std::cout << "Inserted control point " << insert_at << " at: " << ground.x << ", " << ground.y << std::endl;
+        } else {
+            track_history->add_point(*trackEditor, ground);
+            selected_point = trackEditor->control_points.size() - 1;
+            std::cout << "Added control point at: " << ground.x << ", " << ground.y << std::endl;
+        }
         
-        if (fabs(rayDir.y) > 0.0001f) {
-            float t = -cameraPos.y / rayDir.y;
-            glm::vec3 worldPos = cameraPos + t * rayDir;
-            
-            trackEditor->add_control_point(glm::vec2(worldPos.x, worldPos.z));
-            std::cout << "Added control point at: " << worldPos.x << ", " << worldPos.z << std::endl;
-            
-            if (trackEditor->control_points.size() >= 4) {
-                update_track_preview();
-            }
+        if (trackEditor->control_points.size() >= 4) {
+            update_track_preview();
+        }
+    }
+    else if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE && dragging_point) {
+        // The drag already rewrote the chunks it touched; flush any move still pending
+        dragging_point = false;
+        track_history->end_merge();
+        if (trackEditor->control_points.size() >= 4) {
+            update_track_preview();
+        }
+        track_preview_dirty = false;
+    }
+    else if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
+        int picked = pick_control_point(xpos, ypos);
+        if (picked >= 0) {
+            selected_point = picked;
+            remove_selected_control_point();
         }
     }
 }
 
-void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
+void handle_cursor(double xpos, double ypos) {
     if (current_mode == 0) {
         track_editor(xpos, ypos);
     }
@@ -256,24 +495,183 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     }
 }
 
+void load_static_track(){
+    // Prefer the cached mesh in the track document, fall back to the exported OBJ
+    if (TrackDocument::load_geometry(scene_manifest.track_document, loaded_track)) {
+        loaded_track->obj_file = scene_manifest.track_document;
+    } else {
+        loaded_track->obj_file = scene_manifest.track_obj;
+        loaded_track->buffers_created = 0;
+        Obj3DWriter::forget(scene_manifest.track_obj);
+        Obj3DWriter::write(loaded_track);
+        loaded_track->calculate_bbox();
+    }
+}
+
+// Scatters instances of the config props around the track; they share the
+// props' meshes, so only the transforms are new.
+void spawn_prop_field(size_t count) {
+    std::vector<std::shared_ptr<Obj3D>> sources;
+    for (const auto& prop : scene_props) {
+        if (prop->mesh && prop->has_bounds) sources.push_back(prop);
+    }
+    if (sources.empty()) {
+        std::cout << "No props loaded to scatter" << std::endl;
+        return;
+    }
+
+    glm::vec3 lo(-100.0f, 0.0f, -100.0f), hi(100.0f, 0.0f, 100.0f);
+    if (loaded_track->has_bounds) {
+        lo = loaded_track->bbox->min - glm::vec3(20.0f);
+        hi = loaded_track->bbox->max + glm::vec3(20.0f);
+    }
+
+    std::mt19937 rng(simulation_seed);
+    std::uniform_real_distribution<float> x(lo.x, hi.x), z(lo.z, hi.z), angle(0.0f, glm::radians(360.0f));
+    for (size_t i = 0; i < count; i++) {
+        const auto& source = sources[i % sources.size()];
+        auto obj = std::make_shared<Obj3D>();
+        obj->name = source->name + "_" + std::to_string(i);
+        obj->obj_file = source->obj_file;
+        obj->mesh = source->mesh;
+        obj->buffers_created = true;
+        *obj->bbox = *source->bbox;
+        obj->has_bounds = true;
+        obj->transform = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(x(rng), 0.0f, z(rng))),
+                                     angle(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+        current_scene->add_object(obj);
+    }
+    std::cout << "Scattered " << count << " props, scene has " << current_scene->objects.size() << " objects" << std::endl;
+}
+
+void toggle_chase_camera() {
+    auto& hierarchy = current_scene->hierarchy;
+    if (hierarchy.contains(chase_camera_node)) {
+        hierarchy.remove_node(chase_camera_node);
+        chase_camera_node = TransformHierarchy::NONE;
+        std::cout << "Free camera" << std::endl;
+        return;
+    }
+    uint32_t car_node = current_scene->node_of(racecar->scene_handle);
+    if (car_node == TransformHierarchy::NONE) return;
+    chase_camera_node = hierarchy.add_node(glm::translate(glm::mat4(1.0f), CHASE_CAMERA_OFFSET), car_node);
+    std::cout << "Chase camera" << std::endl;
+}
+
+void follow_chase_camera() {
+    if (!current_scene->hierarchy.contains(chase_camera_node)) return;
+    const glm::mat4& world = current_scene->hierarchy.worlds[chase_camera_node];
+    cameraPos = glm::vec3(world[3]);
+    cameraFront = glm::normalize(glm::vec3(world * glm::vec4(0.0f, -0.3f, 1.0f, 0.0f)));
+}
+
+// Moves the selection to the next selectable object in scene order (step 1) or the previous one (step -1)
+void select_next_object(int step) {
+    int count = (int)current_scene->size();
+    if (count == 0) return;
+    int start = (int)current_scene->index_of(selected_handle);
+    if (start < 0 || start >= count) start = step > 0 ? count - 1 : 0;
+    for (int i = 1; i <= count; i++) {
+        int index = ((start + step * i) % count + count) % count;
+        if (current_scene->flags[index] & Scene::SELECTABLE) {
+            selected_handle = current_scene->handle_at(index);
+            return;
+        }
+    }
+}
+
+void print_render_stats() {
+    std::cout << "Objects: " << objects_visible << " visible, " << objects_culled << " culled, cull "
+              << cull_ms << " ms | chunks: " << chunks_visible << " visible, " << chunks_culled << " culled | "
+              << triangles_drawn << " triangles | " << draw_calls << " draw calls, " << instanced_batches
+              << " instanced batches, " << instance_buffer.bytes_uploaded << " instance bytes | "
+              << (use_indirect ? "indirect: " : "indirect off: ") << indirect_renderer.command_count << " commands in "
+              << indirect_renderer.submit_calls << " calls, pool " << geometry_pool.gpu_bytes() << " bytes" << std::endl;
+}
+
+void load_track_animation(std::shared_ptr<Animation> animation){
+    animation->keyframes.clear();
+    if (!TrackDocument::load_centerline(scene_manifest.track_document, animation->keyframes)) {
+        // The binary keyframes cache the text path; rebuild them when the text is newer
+        std::error_code binary_error, text_error;
+        auto binary_time = fs::last_write_time(scene_manifest.track_keyframes, binary_error);
+        auto text_time = fs::last_write_time(scene_manifest.track_animation, text_error);
+        bool cache_valid = !binary_error && (text_error || binary_time >= text_time);
+        if (!cache_valid || !animation->load_binary(scene_manifest.track_keyframes)) {
+            animation->load_from_file(scene_manifest.track_animation);
+            if (!animation->keyframes.empty()) {
+                animation->save_binary(scene_manifest.track_keyframes);
+            }
+        }
+    }
+    animation->constant_speed = true;
+    animation->build_arc_length_table();
+}
+
+void reload_exported_track(){
+    load_static_track();
+    load_track_animation(racecar->animation);
+}
+
 void finish_track(){
-    trackEditor->export_track_OBJ("../objs/track/exported_track.obj");
-    trackEditor->export_animation_file("../objs/track/animation_path.txt");
+    if (!track_exporter->start(*trackEditor, scene_manifest.track_obj, scene_manifest.track_animation, scene_manifest.track_document)) {
+        return;
+    }
+    reload_track_after_export = true;
     trackEditor->clear_control_points();
+    track_history->reset();
+    selected_point = hovered_point = -1;
+    dragging_point = false;
     if (current_track) {
-        auto it = std::find(current_scene->objects.begin(), current_scene->objects.end(), current_track);
-        if (it != current_scene->objects.end()) {
-            current_scene->objects.erase(it);
+        if (current_scene->contains(*current_track)) {
+            current_scene->remove_object(current_track->scene_handle);
+        }
+    }
+}
+
+// Ctrl+Z / Ctrl+Y (or Ctrl+Shift+Z)
+void step_track_history(bool forward){
+    if (dragging_point) return;
+    bool stepped = forward ? track_history->redo(*trackEditor) : track_history->undo(*trackEditor);
+    if (!stepped) return;
+
+    if (selected_point >= (int)trackEditor->control_points.size()) selected_point = -1;
+    hovered_point = -1;
+    std::cout << (forward ? "Redo" : "Undo") << " (" << track_history->position() << "/"
+              << track_history->size() << ")" << std::endl;
+    if (trackEditor->control_points.size() >= 4) {
+        update_track_preview();
+    } else {
+        if (current_scene->contains(*current_track)) {
+            current_scene->remove_object(current_track->scene_handle);
         }
     }
-    loaded_track->buffers_created = 0;
-    Obj3DWriter::write(loaded_track);
-    racecar->animation->keyframes.clear();
-    racecar->animation->load_from_file("../objs/track/animation_path.txt");
 }
 
-void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+void poll_track_export(){
+    TrackExportResult result;
+    if (!track_exporter->poll(result)) return;
+
+    if (result.obj_file.empty()) {
+        // Ctrl+S: only the document was written, TrackDocument::save reports it
+        if (!result.success) std::cout << "Track save failed" << std::endl;
+        return;
+    }
+    if (!result.success) {
+        std::cout << "Track export failed" << std::endl;
+        reload_track_after_export = false;
+        return;
+    }
+    std::cout << "Track exported! (" << result.bytes_written << " bytes in " << result.milliseconds << " ms)" << std::endl;
+    if (reload_track_after_export) {
+        reload_track_after_export = false;
+        reload_exported_track();
+    }
+}
+
+void handle_key(GLFWwindow* window, int key, int action, int mods)
 {
+    if (key >= 0 && key <= GLFW_KEY_LAST) held_keys[key] = action != GLFW_RELEASE;
     if (action == GLFW_PRESS) {
         if (key == GLFW_KEY_TAB) {
             current_mode = (current_mode + 1) % 2;
@@ -285,112 +683,204 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
             }
         }
         else if (key == GLFW_KEY_E && current_mode == 0) {
-            trackEditor->export_track_OBJ("../objs/track/exported_track.obj");
-            trackEditor->export_animation_file("../objs/track/animation_path.txt");
-            std::cout << "Track exported!" << std::endl;
+            track_exporter->start(*trackEditor, scene_manifest.track_obj, scene_manifest.track_animation, scene_manifest.track_document);
+        }
+        else if (key == GLFW_KEY_S && (mods & GLFW_MOD_CONTROL) && current_mode == 0) {
+            track_exporter->save(*trackEditor, scene_manifest.track_document);
+        }
+        else if (key == GLFW_KEY_O && (mods & GLFW_MOD_CONTROL) && current_mode == 0) {
+            selected_point = hovered_point = -1;
+            // A save still running would be writing the same file
+            track_exporter->wait();
+            if (TrackDocument::load(scene_manifest.track_document, *trackEditor)) {
+                track_history->reset();
+                if (trackEditor->control_points.size() >= 4) {
+                    update_track_preview();
+                }
+            }
+        }
+        else if (key == GLFW_KEY_Z && (mods & GLFW_MOD_CONTROL) && current_mode == 0) {
+            step_track_history((mods & GLFW_MOD_SHIFT) != 0);
+        }
+        else if (key == GLFW_KEY_Y && (mods & GLFW_MOD_CONTROL) && current_mode == 0) {
+            step_track_history(true);
         }
         else if (key == GLFW_KEY_BACKSPACE && current_mode == 0) {
             //IF BACKSPACE REMOVE LAST CONTROL POINT
-            trackEditor->pop_back_control_points();
+            track_history->pop_point(*trackEditor);
+            if (selected_point >= (int)trackEditor->control_points.size()) selected_point = -1;
+            hovered_point = -1;
             update_track_preview();
         }
+        else if (key == GLFW_KEY_DELETE && current_mode == 0) {
+            remove_selected_control_point();
+        }
+        else if (key == GLFW_KEY_LEFT_BRACKET && current_mode == 0) {
+            adjust_selected_control_point(-0.1f, 0.0f, 0.0f);
+        }
+        else if (key == GLFW_KEY_RIGHT_BRACKET && current_mode == 0) {
+            adjust_selected_control_point(0.1f, 0.0f, 0.0f);
+        }
+        else if (key == GLFW_KEY_R && current_mode == 0) {
+            adjust_selected_control_point(0.0f, 0.0f, 0.1f);
+        }
+        else if (key == GLFW_KEY_F && current_mode == 0) {
+            adjust_selected_control_point(0.0f, 0.0f, -0.1f);
+        }
+        else if (key == GLFW_KEY_N && current_mode == 0) {
+            adjust_selected_control_point(0.0f, glm::radians(-2.0f), 0.0f);
+        }
+        else if (key == GLFW_KEY_M && current_mode == 0) {
+            adjust_selected_control_point(0.0f, glm::radians(2.0f), 0.0f);
+        }
+        else if (key == GLFW_KEY_P && current_mode == 0) {
+            cycle_track_profile();
+        }
         else if (key == GLFW_KEY_C && current_mode == 0) {
             // CLEAR POINTS
-            trackEditor->clear_control_points();
+            track_history->clear(*trackEditor);
+            selected_point = hovered_point = -1;
+            dragging_point = false;
             if (current_track) {
-                auto it = std::find(current_scene->objects.begin(), current_scene->objects.end(), current_track);
-                if (it != current_scene->objects.end()) {
-                    current_scene->objects.erase(it);
+                if (current_scene->contains(*current_track)) {
+                    current_scene->remove_object(current_track->scene_handle);
                 }
             }
         }
         else if (key == GLFW_KEY_ENTER && current_mode == 0) {
             finish_track();
         }
-        else if (key == GLFW_KEY_PAGE_DOWN) {
-            int size = current_scene->objects.size();
-            if (currentObjectIndex == 0) {
-                currentObjectIndex = size-1;
-            }
-            int f = currentObjectIndex-1;
-            for (int i = 0; i < current_scene->objects.size(); i++){
-                if (f <= 0) {f = current_scene->objects.size()-1;}
-                if (current_scene->objects[f]->selectable) {
-                    currentObjectIndex = f;
-                    break;
-                }
-                f--;
+        else if (key == GLFW_KEY_F3) {
+            print_render_stats();
+        }
+        else if (key == GLFW_KEY_F4) {
+            spawn_prop_field(PROP_FIELD_SIZE);
+        }
+        else if (key == GLFW_KEY_F6) {
+#ifdef RACETRACK_PROFILE
+            Profiler::print_table(std::cout);
+#else
+            std::cout << "Profiler disabled, build with -DRACETRACK_PROFILE" << std::endl;
+#endif
+        }
+        else if (key == GLFW_KEY_F7) {
+            if (Profiler::write_chrome_trace(PROFILE_TRACE_FILE)) {
+                std::cout << "Wrote " << PROFILE_TRACE_FILE << std::endl;
+            } else {
+                std::cout << "No profile events recorded" << std::endl;
             }
         }
+        else if (key == GLFW_KEY_F8) {
+            Stats::print(std::cout);
+        }
+        else if (key == GLFW_KEY_F5) {
+            use_indirect = !use_indirect;
+            std::cout << "Indirect submission " << (use_indirect ? "on" : "off") << std::endl;
+        }
+        else if (key == GLFW_KEY_PAGE_DOWN) {
+            select_next_object(-1);
+        }
         else if (key == GLFW_KEY_PAGE_UP) {
-            int size = current_scene->objects.size();
-            if (currentObjectIndex == size-1) {
-                currentObjectIndex = 0;
-            }
-            int f = currentObjectIndex+1;
-            for (int i = 0; i < current_scene->objects.size(); i++){
-                if (current_scene->objects[f]->selectable) {
-                    currentObjectIndex = f;
-                    break;
-                }
-                if (f >= current_scene->objects.size()-1) {f = 0;}
-                f++;
-            }
+            select_next_object(1);
         }
         
         else if (key == GLFW_KEY_SPACE && current_mode == 1) {
             bullet_manager->addBullet(cameraPos, cameraFront);
         }
+        else if (key == GLFW_KEY_V && current_mode == 1) {
+            toggle_chase_camera();
+        }
     }
 }
 
+bool key_down(int key) {
+    return held_keys[key];
+}
+
 void processInput(GLFWwindow* window) {
     float cameraSpeed = 5.0f * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+    if (key_down(GLFW_KEY_LEFT_SHIFT))
         cameraSpeed *= 3;
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    if (key_down(GLFW_KEY_ESCAPE))
         glfwSetWindowShouldClose(window, true);
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if (key_down(GLFW_KEY_W))
         cameraPos += cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (key_down(GLFW_KEY_S))
         cameraPos -= cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (key_down(GLFW_KEY_A))
         cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (key_down(GLFW_KEY_D))
         cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
         
-    if (currentObjectIndex < current_scene->objects.size()){
-        if (current_scene->objects[currentObjectIndex]->selectable) {
-            if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
+    uint32_t selected = current_scene->index_of(selected_handle);
+    if (selected != Scene::INVALID_INDEX){
+        if (current_scene->flags[selected] & Scene::SELECTABLE) {
+            Obj3D& obj = *current_scene->objects[selected];
+            if (key_down(GLFW_KEY_UP)) {
                 glm::vec3 v(0.0f, 0.0f, -0.1f);
-                current_scene->objects[currentObjectIndex]->transform = glm::translate(current_scene->objects[currentObjectIndex]->transform, v);
+                obj.set_transform(glm::translate(obj.transform, v));
             }
-            else if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) {
+            else if (key_down(GLFW_KEY_RIGHT)) {
                 glm::vec3 v(0.1f, 0.0f, 0.0f);
-                current_scene->objects[currentObjectIndex]->transform = glm::translate(current_scene->objects[currentObjectIndex]->transform, v);
+                obj.set_transform(glm::translate(obj.transform, v));
                 
             }
-            else if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {
+            else if (key_down(GLFW_KEY_LEFT)) {
                 glm::vec3 v(-0.1f, 0.0f, 0.0f);
-                current_scene->objects[currentObjectIndex]->transform = glm::translate(current_scene->objects[currentObjectIndex]->transform, v);
+                obj.set_transform(glm::translate(obj.transform, v));
                 
             }
-            else if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
+            else if (key_down(GLFW_KEY_DOWN)) {
                 glm::vec3 v(0.0f, 0.0f, 0.1f);
-                current_scene->objects[currentObjectIndex]->transform = glm::translate(current_scene->objects[currentObjectIndex]->transform, v);
+                obj.set_transform(glm::translate(obj.transform, v));
             }
-            else if (glfwGetKey(window, GLFW_KEY_KP_1) == GLFW_PRESS) {
-                current_scene->objects[currentObjectIndex]->transform = glm::rotate(current_scene->objects[currentObjectIndex]->transform, -0.02f, glm::vec3(0,1,0));
+            else if (key_down(GLFW_KEY_KP_1)) {
+                obj.set_transform(glm::rotate(obj.transform, -0.02f, glm::vec3(0,1,0)));
             }
-            else if (glfwGetKey(window, GLFW_KEY_KP_2) == GLFW_PRESS) {
-                current_scene->objects[currentObjectIndex]->transform = glm::rotate(current_scene->objects[currentObjectIndex]->transform, 0.02f, glm::vec3(0,1,0));
+            else if (key_down(GLFW_KEY_KP_2)) {
+                obj.set_transform(glm::rotate(obj.transform, 0.02f, glm::vec3(0,1,0)));
             }
         }
     }
 }
 
+// GLFW callbacks: live input is recorded when --record is set and ignored while replaying
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (input_player.active()) return;
+    input_recorder.key(key, action, mods);
+    handle_key(window, key, action, mods);
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if (input_player.active()) return;
+    double xpos, ypos;
+    glfwGetCursorPos(window, &xpos, &ypos);
+    input_recorder.mouse_button(button, action, mods, xpos, ypos);
+    handle_mouse_button(button, action, mods, xpos, ypos);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
+    if (input_player.active()) return;
+    input_recorder.cursor(xpos, ypos);
+    handle_cursor(xpos, ypos);
+}
+
+// Feeds the events recorded during this frame's poll back through the same handlers
+void dispatch_replayed_input(GLFWwindow* window) {
+    InputEvent event;
+    while (input_player.next_event(event)) {
+        if (event.type == InputEvent::KEY) {
+            handle_key(window, event.code, event.action, event.mods);
+        } else if (event.type == InputEvent::MOUSE_BUTTON) {
+            handle_mouse_button(event.code, event.action, event.mods, event.x, event.y);
+        } else if (event.type == InputEvent::CURSOR) {
+            handle_cursor(event.x, event.y);
+        }
+    }
+}
+
 void specify_view() {
-    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+    glm::mat4 view = camera_view();
     GLuint loc = glGetUniformLocation(shaderID, "view");
     glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(view));
     
@@ -399,7 +889,7 @@ void specify_view() {
 }
 
 void specify_projection() {
-    glm::mat4 proj = glm::perspective(glm::radians(fov), (float)WIDTH / HEIGHT, 0.1f, 100.0f);
+    glm::mat4 proj = camera_projection();
     GLuint loc = glGetUniformLocation(shaderID, "projection");
     glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(proj));
 }
@@ -442,103 +932,6 @@ GLuint setup_shader() {
     return shaderProgram;
 }
 
-void setup_point_buffers(GLuint& VAO, GLuint& VBO) {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    glBindVertexArray(0);
-}
-
-GLuint setup_point_shader() {
-    const GLchar* pointVertexShader = R"glsl(
-        #version 450 core
-        layout (location = 0) in vec3 position;
-        uniform mat4 view;
-        uniform mat4 projection;
-        void main() {
-            gl_Position = projection * view * vec4(position, 1.0);
-            gl_PointSize = 12.0;
-        }
-    )glsl";
-    
-    const GLchar* pointFragmentShader = R"glsl(
-        #version 450 core
-        out vec4 FragColor;
-        void main() {
-            vec2 coord = gl_PointCoord - vec2(0.5);
-            float dist = length(coord);
-            
-            if(dist > 0.5)
-                discard;
-                
-            if(dist > 0.4) {
-                FragColor = vec4(0.0, 0.0, 0.0, 1.0); 
-            } else {
-                FragColor = vec4(1.0, 1.0, 1.0, 1.0); 
-            }
-        }
-    )glsl";
-    
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &pointVertexShader, nullptr);
-    glCompileShader(vertexShader);
-    
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &pointFragmentShader, nullptr);
-    glCompileShader(fragmentShader);
-    
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    
-    return shaderProgram;
-}
-
-void render_control_points() {
-    auto controlPoints = trackEditor->control_points;
-    if (controlPoints.empty()) return;
-    
-    static GLuint pointVAO = 0, pointVBO = 0;
-    
-    if (pointShader == 0) {
-        pointShader = setup_point_shader();
-    }
-    if (pointVAO == 0) {
-        setup_point_buffers(pointVAO, pointVBO);
-    }
-    
-    glUseProgram(pointShader);
-    
-    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-    glm::mat4 projection = glm::perspective(glm::radians(fov), (float)WIDTH / HEIGHT, 0.1f, 100.0f);
-    
-    glUniformMatrix4fv(glGetUniformLocation(pointShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(pointShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    
-    std::vector<glm::vec3> pointPositions;
-    for (const auto& point : controlPoints) {
-        pointPositions.push_back(glm::vec3(point.x, 0.1f, point.y));
-    }
-    
-    glBindVertexArray(pointVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, pointVBO);
-    glBufferData(GL_ARRAY_BUFFER, pointPositions.size() * sizeof(glm::vec3), pointPositions.data(), GL_DYNAMIC_DRAW);
-    
-    glPointSize(8.0f);
-    glDrawArrays(GL_POINTS, 0, pointPositions.size());
-    glBindVertexArray(0);
-}
-
 unsigned int load_texture_from_file(const std::string& filename, const std::string& directory) {
     std::string fullPath = directory + "/" + filename;
     
@@ -546,39 +939,14 @@ unsigned int load_texture_from_file(const std::string& filename, const std::stri
     
     std::cout << "Loading texture: " << fullPath << std::endl;
     
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    
-    int width, height, nrComponents;
-    stbi_set_flip_vertically_on_load(true); 
-    unsigned char* data = stbi_load(fullPath.c_str(), &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-        
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        
-        stbi_image_free(data);
-        std::cout << "Texture loaded successfully: " << fullPath << " (" << width << "x" << height << ")" << std::endl;
-    } else {
+    TextureImage image;
+    if (!image.load(fullPath)) {
         std::cout << "Texture failed to load at path: " << fullPath << std::endl;
-        stbi_image_free(data);
-        glDeleteTextures(1, &textureID);
         return 0;
     }
-    
+    unsigned int textureID = RenderDevice::current().create_texture(image);
+    Stats::note_event("texture " + fullPath);
+    std::cout << "Texture loaded successfully: " << fullPath << " (" << image.width << "x" << image.height << ")" << std::endl;
     return textureID;
 }
 
@@ -668,33 +1036,203 @@ void setup_light_uniforms(GLuint shaderProgram, glm::vec3 lightPos) {
     glUniform1f(glGetUniformLocation(shaderProgram, "fogEnd"), 50.0f);
 }
 
+void bind_group_material(const std::shared_ptr<Obj3D>& obj, const std::shared_ptr<Group>& group) {
+    Stats::add(Stats::STATE_CHANGES);
+    setup_default_material(shaderID);
+    if (group->material){
+        std::string directory = obj->obj_file.substr(0, obj->obj_file.find_last_of("/\\"));
+        setup_material_uniforms(shaderID, group->material, directory);
+    }
+}
+
+void draw_object(const std::shared_ptr<Obj3D>& obj, const Frustum& frustum, GLint model_loc) {
+    if (model_loc != -1) {
+        glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(obj->transform));
+    }
+    for (auto group : obj->mesh->groups) {
+        if (group->vert_count == 0) continue;
+        GLint first = 0;
+        GLsizei count = group->vert_count;
+        if (group->has_bounds) {
+            BoundingBox world_bounds = group->bounds.transformed(obj->transform);
+            if (!frustum.intersects(world_bounds)) {
+                chunks_culled++;
+                continue;
+            }
+            chunks_visible++;
+            int level = select_lod(*group, world_bounds);
+            if (level >= 0) {
+                first = group->lods[level].first;
+                count = group->lods[level].count;
+            }
+        }
+        bind_group_material(obj, group);
+        glBindVertexArray(group->VAO);
+        Stats::add(Stats::STATE_CHANGES);
+        glDrawArrays(GL_TRIANGLES, first, count);
+        triangles_drawn += count / 3;
+        draw_calls++;
+    }
+}
+
+// Draws visible_entities[first, last), which all share one mesh, with a single
+// instanced call per group
+void draw_instanced(size_t first, size_t last, GLint instancing_loc) {
+    static std::vector<glm::mat4> transforms;
+    transforms.clear();
+    for (size_t i = first; i < last; i++) {
+        transforms.push_back(current_scene->transforms[visible_entities[i]]);
+    }
+    instance_buffer.upload(transforms);
+
+    const auto& obj = current_scene->objects[visible_entities[first]];
+    glUniform1i(instancing_loc, 1);
+    for (auto group : obj->mesh->groups) {
+        if (group->vert_count == 0) continue;
+        instance_buffer.attach(group);
+        bind_group_material(obj, group);
+        glBindVertexArray(group->VAO);
+        Stats::add(Stats::STATE_CHANGES);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, group->vert_count, (GLsizei)transforms.size());
+        triangles_drawn += (group->vert_count / 3) * transforms.size();
+        draw_calls++;
+    }
+    glUniform1i(instancing_loc, 0);
+    instanced_batches++;
+}
+
+bool is_instanceable(const Mesh& mesh) {
+    // Chunked meshes cull and pick LODs per group, which needs one object per draw
+    return std::none_of(mesh.groups.begin(), mesh.groups.end(),
+                        [](const std::shared_ptr<Group>& group) { return group->has_bounds; });
+}
+
 void error_log(int cod, const char * description) {
     std::cout << "GLFW Error (" << cod << "): " << description << std::endl;
 }
 
 void setup_track(){
     loaded_track->name = "Static Track";
-    loaded_track->obj_file = "../objs/track/exported_track.obj";
     //loaded_track->collidable = true;
     current_scene->add_object(loaded_track);
-    Obj3DWriter::write(loaded_track);
+    load_static_track();
     
     
     racecar->name = "Racecar";
-    racecar->obj_file = "../objs/track/car.obj";
+    racecar->obj_file = scene_manifest.car;
+    racecar->collidable = true;
     current_scene->add_object(racecar);
     std::shared_ptr<Animation> animation = std::make_shared<Animation>();
-    animation->load_from_file("../objs/track/animation_path.txt");
-    racecar->set_animation(animation);
-    
-    Obj3DWriter::write(racecar);
-    
-    racecar->collidable = true;
-    racecar->calculate_bbox();
-   
+    load_track_animation(animation);
+    // The follower moves the car; kept on the object so a track reload refreshes the path
+    racecar->animation = animation;
+    animation_system->add_follower(animation_system->add_path(animation), 0.0f, 1.0f, 0.0f, racecar);
 }
 
-int main() {
+// Adds the manifest's objects and their instances to the scene; the meshes arrive through the loader
+std::vector<SceneLoader::Request> create_manifest_objects() {
+    std::vector<SceneLoader::Request> requests = {{racecar}};
+    std::unordered_map<std::string, std::shared_ptr<Obj3D>> by_name = {{"track", loaded_track}, {"car", racecar}};
+    for (const auto& entry : scene_manifest.objects) {
+        bool shared = entry.cache == ManifestObject::SHARED;
+        std::shared_ptr<Obj3D> parent;
+        if (!entry.parent.empty()) {
+            auto it = by_name.find(entry.parent);
+            if (it != by_name.end()) parent = it->second;
+            else std::cerr << "Parent " << entry.parent << " of " << entry.name << " not found, placed in the world" << std::endl;
+        }
+        auto add = [&](const std::string& name, const glm::mat4& transform) {
+            auto obj = std::make_shared<Obj3D>();
+            obj->name = name;
+            obj->obj_file = entry.obj_file;
+            obj->selectable = entry.selectable;
+            obj->collidable = entry.collidable;
+            obj->eliminable = entry.eliminable;
+            obj->transform = transform;
+            current_scene->add_object(obj);
+            if (parent) {
+                current_scene->attach(obj->scene_handle, parent->scene_handle, transform);
+            }
+            requests.push_back({obj, entry.priority, shared});
+            return obj;
+        };
+        scene_props.push_back(add(entry.name, entry.transform()));
+        by_name.emplace(entry.name, scene_props.back());
+        for (size_t i = 0; i < entry.instances.size(); i++) {
+            add(entry.name + "_" + std::to_string(i + 1), entry.instances[i]);
+        }
+    }
+    std::cout << "Scene " << scene_file << ": " << scene_manifest.objects.size() << " entries, "
+              << scene_manifest.instance_count() << " objects" << std::endl;
+    return requests;
+}
+
+// Called by the scene loader on the context thread once an object's mesh is on the GPU
+void on_object_loaded(const std::shared_ptr<Obj3D>& obj) {
+    if (!obj->mesh) return;
+    obj->calculate_bbox();
+    geometry_pool.add(*obj);
+}
+
+void pump_scene_loader(GLFWwindow* window) {
+    if (!scene_loader.loading()) return;
+    size_t before = scene_loader.done();
+    scene_loader.pump(LOAD_BUDGET_MS, on_object_loaded);
+    if (scene_loader.done() == before) return;
+
+    if (scene_loader.loading()) {
+        std::string title = WINDOW_TITLE + " - loading " + std::to_string(scene_loader.done()) + "/" +
+                            std::to_string(scene_loader.total());
+        glfwSetWindowTitle(window, title.c_str());
+    } else {
+        glfwSetWindowTitle(window, WINDOW_TITLE.c_str());
+        std::cout << "Loaded " << scene_loader.total() << " objects from " << scene_loader.files() << " files in "
+                  << scene_loader.elapsed_ms() << " ms" << std::endl;
+    }
+}
+
+bool parse_arguments(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--stats") stats_file = value;
+        else if (arg == "--stats-interval") stats_interval = std::atoi(value);
+        else if (arg == "--record") record_file = value;
+        else if (arg == "--replay") replay_file = value;
+        else if (arg == "--seed") simulation_seed = std::atoi(value);
+        else if (arg == "--scene") scene_file = value;
+        else {
+            cerr << "Unknown option " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    program_start = std::chrono::steady_clock::now();
+    if (!parse_arguments(argc, argv)) {
+        return 1;
+    }
+    if (!stats_file.empty()) {
+        Stats::open_dump(stats_file, stats_interval);
+    }
+    if (!replay_file.empty()) {
+        if (!input_player.open(replay_file)) return 1;
+        simulation_seed = input_player.seed;
+    } else if (headless) {
+        cerr << "--headless needs --replay" << endl;
+        return 1;
+    }
+
     if (!glfwInit()) {
         fprintf(stderr, "ERROR: could not start GLFW3\n");
         return 1;
@@ -704,8 +1242,11 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
 
-    window = glfwCreateWindow(WIDTH, HEIGHT, "Racetrack Editor", NULL, NULL);
+    window = glfwCreateWindow(WIDTH, HEIGHT, WINDOW_TITLE.c_str(), NULL, NULL);
     if (!window) {
         fprintf(stderr, "ERROR: could not open window with GLFW3\n");
         glfwTerminate();
@@ -713,6 +1254,10 @@ int main() {
     }
 
     glfwMakeContextCurrent(window);
+    // Replays run as fast as the machine allows instead of at the display rate
+    if (input_player.active()) {
+        glfwSwapInterval(0);
+    }
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         cerr << "Failure to start GLAD" << endl;
@@ -737,17 +1282,23 @@ int main() {
     //STARTUP LOGIC
     //cameraPos = glm::vec3(0.0f, 10.0f, 0.0f); 
     //cameraFront = glm::vec3(0.0f, -50.0f, -1.0f);
-    if (pointShader == 0) {
-    pointShader = setup_point_shader();
-    }
+    track_overlay.init();
+    instance_buffer.init();
+    geometry_pool.init(1 << 16, 1 << 17);
+    indirect_renderer.init();
     current_scene = std::make_unique<Scene>();
+    if (!fs::exists(scene_file) || !scene_manifest.load(scene_file)) {
+        std::cout << "Using legacy " << LEGACY_CONFIG_FILE << std::endl;
+        scene_manifest = SceneManifest();
+        scene_manifest.load(LEGACY_CONFIG_FILE);
+    }
     setup_track();
-    for (auto obj : Obj3DWriter::file_reader())
-    {
-        current_scene->add_object(obj);
-        Obj3DWriter::write(obj);
-        if (obj->collidable) {
-            obj->calculate_bbox();
+    scene_loader.start(create_manifest_objects());
+    // Recorded and replayed sessions need every object in place on the first frame
+    if (!record_file.empty() || input_player.active()) {
+        while (scene_loader.loading()) {
+            scene_loader.wait();
+            pump_scene_loader(window);
         }
     }
 
@@ -761,31 +1312,71 @@ int main() {
     current_mode = 0;
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
     
-    int size = current_scene->objects.size();
-    if (currentObjectIndex == size-1) {
-        currentObjectIndex = 0;
-    }
-    int f = currentObjectIndex+1;
-    for (int i = 0; i < current_scene->objects.size(); i++){
-        if (current_scene->objects[f]->selectable) {
-            currentObjectIndex = f;
-            break;
-        }
-        if (f >= current_scene->objects.size()-1) {f = 0;}
-        f++;
+    select_next_object(1);
+
+    if (!record_file.empty()) {
+        input_recorder.start(record_file, simulation_seed);
     }
+    double replay_begin = glfwGetTime();
 
     while (!glfwWindowShouldClose(window)) {
+        PROFILE_COLLECT();
+        PROFILE_GPU_COLLECT(gpu_timer);
+        PROFILE_SCOPE("frame");
 
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        // A replay steps with the recorded dt, however long this frame really took
+        if (input_player.active() && !input_player.next_frame(deltaTime)) {
+            double seconds = glfwGetTime() - replay_begin;
+            std::cout << "Replay finished: " << input_player.frames << " frames in " << seconds << " s ("
+                      << seconds * 1000.0 / std::max(input_player.frames, size_t(1)) << " ms/frame)" << std::endl;
+            break;
+        }
+        input_recorder.frame(deltaTime);
 
-        processInput(window);
+        {
+            PROFILE_SCOPE("loading");
+            pump_scene_loader(window);
+        }
 
-        bullet_manager->update(deltaTime);
-        bullet_manager->checkCollisions(current_scene->objects);
+        {
+            PROFILE_SCOPE("input");
+            processInput(window);
+            // Exports finish on a worker thread; recorded and replayed sessions wait so the reload lands on the same frame
+            if (input_player.active() || input_recorder.recording()) {
+                track_exporter->wait();
+            }
+            poll_track_export();
+            if (track_preview_dirty) {
+                track_preview_dirty = false;
+                if (trackEditor->control_points.size() >= 4) {
+                    update_track_preview();
+                }
+            }
+        }
+
+        {
+            PROFILE_SCOPE("animation");
+            current_scene->animate(deltaTime);
+            animation_system->update(deltaTime, 0);
+            animation_system->apply_transforms();
+            current_scene->update_hierarchy();
+            follow_chase_camera();
+            current_scene->update_bounds();
+        }
+
+        {
+            PROFILE_SCOPE("bullet_update");
+            bullet_manager->update(deltaTime);
+        }
+        {
+            PROFILE_SCOPE("collisions");
+            bullet_manager->checkCollisions(*current_scene);
+        }
 
+        PROFILE_GPU_BEGIN(gpu_timer, "gpu_scene");
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
@@ -806,40 +1397,112 @@ int main() {
 
         GLuint loc = glGetUniformLocation(shaderID, "model");
 
-        for (auto obj : current_scene->objects) {
-            if (loc != -1) {
-                glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(obj->transform));
+        glm::mat4 view = camera_view();
+        glm::mat4 projection = camera_projection();
+        Frustum frustum;
+        frustum.extract(projection * view);
+        chunks_visible = 0;
+        chunks_culled = 0;
+        triangles_drawn = 0;
+
+        // Cull whole objects first so hidden ones never touch uniforms or groups
+        {
+            PROFILE_SCOPE("culling");
+            auto cull_begin = std::chrono::steady_clock::now();
+            visible_entities.clear();
+            const Scene& scene = *current_scene;
+            for (uint32_t i = 0; i < scene.size(); i++) {
+                if (!scene.meshes[i] || !(scene.flags[i] & Scene::ACTIVE)) continue;
+                if ((scene.flags[i] & Scene::HAS_BOUNDS) &&
+                    !frustum.intersects(scene.world_bounds[i].min, scene.world_bounds[i].max)) {
+                    continue;
+                }
+                visible_entities.push_back(i);
             }
-            if (obj->mesh){
-                for (auto group : obj->mesh->groups) {
-                    setup_default_material(shaderID);
-                    if (group->material){
-                        std::string directory = obj->obj_file.substr(0, obj->obj_file.find_last_of("/\\"));
-                        setup_material_uniforms(shaderID, group->material, directory);
+            objects_visible = (int)visible_entities.size();
+            objects_culled = (int)scene.size() - objects_visible;
+            cull_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cull_begin).count();
+        }
+
+        {
+            PROFILE_SCOPE("draw_submission");
+            // Objects sharing a mesh end up adjacent and are drawn as one instanced batch
+            const auto& meshes = current_scene->meshes;
+            std::sort(visible_entities.begin(), visible_entities.end(), [&meshes](uint32_t a, uint32_t b) {
+                return meshes[a] != meshes[b] ? meshes[a] < meshes[b] : a < b;
+            });
+            GLint instancing_loc = glGetUniformLocation(shaderID, "useInstancing");
+            glUniform1i(instancing_loc, 0);
+            draw_calls = 0;
+            instanced_batches = 0;
+            instance_buffer.reset_stats();
+            indirect_renderer.begin();
+            for (size_t begin = 0; begin < visible_entities.size();) {
+                const Mesh* mesh = meshes[visible_entities[begin]];
+                size_t end = begin + 1;
+                while (end < visible_entities.size() && meshes[visible_entities[end]] == mesh) {
+                    end++;
+                }
+                if (use_indirect && GeometryPool::is_pooled(*mesh)) {
+                    indirect_renderer.add(*current_scene, visible_entities, begin, end);
+                } else if (end - begin >= MIN_INSTANCES && is_instanceable(*mesh)) {
+                    draw_instanced(begin, end, instancing_loc);
+                } else {
+                    for (size_t i = begin; i < end; i++) {
+                        draw_object(current_scene->objects[visible_entities[i]], frustum, loc);
                     }
-                    glBindVertexArray(group->VAO);
-                    glDrawArrays(GL_TRIANGLES, 0, group->vert_count);
                 }
+                begin = end;
             }
-            if (obj->is_animated){
-                obj->update(deltaTime);
-            }
+            glUniform1i(instancing_loc, 1);
+            indirect_renderer.submit(geometry_pool, bind_group_material);
+            glUniform1i(instancing_loc, 0);
+            draw_calls += indirect_renderer.submit_calls;
+            triangles_drawn += indirect_renderer.triangle_count;
+            Stats::add(Stats::DRAW_CALLS, draw_calls);
+            Stats::add(Stats::TRIANGLES, (int64_t)triangles_drawn);
         }
         glBindVertexArray(0);
+        PROFILE_GPU_END(gpu_timer);
 
+        PROFILE_GPU_BEGIN(gpu_timer, "gpu_bullets");
         bullet_manager->render(shaderID);
+        PROFILE_GPU_END(gpu_timer);
 
         if (current_mode == 0) {  
+            PROFILE_SCOPE("overlay");
+            PROFILE_GPU_BEGIN(gpu_timer, "gpu_overlay");
             glDisable(GL_DEPTH_TEST); 
-            render_control_points();
+            track_overlay.sync(*trackEditor);
+            track_overlay.render(view, projection, hovered_point, selected_point);
             glEnable(GL_DEPTH_TEST);
+            PROFILE_GPU_END(gpu_timer);
         }
 
         current_scene->update();
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("swap");
+            glfwSwapBuffers(window);
+            if (Stats::frame_index() == 0) {
+                std::cout << "First frame after " << std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - program_start).count() << " ms" << std::endl;
+            }
+            glfwPollEvents();
+            if (input_player.active()) {
+                dispatch_replayed_input(window);
+            }
+        }
+        Stats::end_frame(deltaTime * 1000.0);
     }
+    Stats::close_dump();
+    input_recorder.stop();
+    track_exporter->wait();
+    track_overlay.cleanup();
+    gpu_timer.cleanup();
+    instance_buffer.cleanup();
+    indirect_renderer.cleanup();
+    geometry_pool.cleanup();
     current_scene->cleanup();
     glfwTerminate();
     return 0;
@@ -0,0 +1,747 @@
+// Microbenchmarks for the hot paths, with a small self-contained harness.
+// Every case runs once per argument in its sweep; each run is calibrated to
+// --min-time, repeated --repeats times and reported as the median ns/op.
+//   ./microbench [--filter text] [--min-time s] [--repeats n]
+//                [--json out.json] [--baseline file.json] [--threshold 0.15]
+// With --baseline, cases slower than baseline * (1 + threshold) are listed as
+// regressions and the exit status is 1. --json writes the results in the
+// baseline format, so a run on the reference machine refreshes the baseline.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <filesystem>
+#include <cstdlib>
+#include <cmath>
+
+#include "classes/logic/track_editor.h"
+#include "classes/logic/track_document.h"
+#include "classes/logic/obj3dwriter.h"
+#include "classes/logic/bullet_manager.h"
+#include "classes/logic/frustum.h"
+#include "classes/logic/transform_hierarchy.h"
+#include "classes/rendering/3D/scene.h"
+#include "classes/rendering/3D/render_device.h"
+
+namespace fs = std::filesystem;
+
+// ---- harness ----
+
+struct BenchContext {
+    long arg = 0;
+    double min_time = 0.2;
+    int repeats = 5;
+    double ns_per_op = 0.0;
+    size_t items_per_op = 1;    // for items/s, e.g. samples per curve evaluation
+    int failures = 0;           // checks that failed; any makes the run exit with 1
+
+    // For cases that also verify results, reported on stderr so the table stays intact
+    void check(bool ok, const std::string& what) {
+        if (ok) return;
+        std::cerr << "check failed: " << what << std::endl;
+        failures++;
+    }
+
+    // Times body(), doubling the batch until a batch takes min_time / repeats
+    template <typename Body>
+    void run(Body body) {
+        using clock = std::chrono::steady_clock;
+        double target = min_time / repeats;
+        size_t batch = 1;
+        std::vector<double> samples;
+        while (true) {
+            auto begin = clock::now();
+            for (size_t i = 0; i < batch; i++) body();
+            double seconds = std::chrono::duration<double>(clock::now() - begin).count();
+            if (seconds >= target || batch >= (1u << 30)) {
+                samples.push_back(seconds * 1e9 / batch);
+                break;
+            }
+            batch = seconds <= 0.0 ? batch * 10 : std::max(batch * 2, (size_t)(batch * target / seconds));
+        }
+        while ((int)samples.size() < repeats) {
+            auto begin = clock::now();
+            for (size_t i = 0; i < batch; i++) body();
+            samples.push_back(std::chrono::duration<double>(clock::now() - begin).count() * 1e9 / batch);
+        }
+        std::sort(samples.begin(), samples.end());
+        ns_per_op = samples[samples.size() / 2];
+    }
+};
+
+struct BenchCase {
+    std::string name;
+    std::vector<long> args;
+    std::function<void(BenchContext&)> fn;
+};
+
+std::vector<BenchCase>& bench_cases() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+void add_case(const std::string& name, std::vector<long> args, std::function<void(BenchContext&)> fn) {
+    bench_cases().push_back({name, std::move(args), std::move(fn)});
+}
+
+// Keeps the optimiser from discarding a result
+template <typename T>
+void do_not_optimize(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+std::map<std::string, double> read_baseline(const std::string& filename) {
+    // Written by write_results: one "name": ns_per_op pair per line
+    std::map<std::string, double> baseline;
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t open = line.find('"');
+        size_t close = line.find('"', open + 1);
+        size_t colon = line.find(':', close);
+        if (open == std::string::npos || close == std::string::npos || colon == std::string::npos) continue;
+        baseline[line.substr(open + 1, close - open - 1)] = std::atof(line.c_str() + colon + 1);
+    }
+    return baseline;
+}
+
+void write_results(const std::string& filename, const std::vector<std::pair<std::string, double>>& results) {
+    std::ofstream file(filename);
+    file << "{\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        file << "  \"" << results[i].first << "\": " << results[i].second << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "}\n";
+}
+
+// ---- synthetic inputs ----
+
+fs::path scratch_dir() {
+    fs::path dir = fs::temp_directory_path() / "racetrack_microbench";
+    fs::create_directories(dir);
+    return dir;
+}
+
+// Grid of quads with positions, uvs and normals, split over a few materials
+std::string make_obj(long quads, long materials) {
+    fs::path dir = scratch_dir();
+    std::string name = "grid_" + std::to_string(quads) + "_" + std::to_string(materials);
+    fs::path obj_path = dir / (name + ".obj");
+    if (fs::exists(obj_path)) return obj_path.string();
+
+    std::ofstream mtl(dir / (name + ".mtl"));
+    for (long m = 0; m < materials; m++) {
+        mtl << "newmtl mat" << m << "\nKa 0.2 0.2 0.2\nKd 0.8 0.5 0.3\nKs 1 1 1\nNs 32\n\n";
+    }
+    long side = std::max(1L, (long)std::sqrt((double)quads));
+    std::ofstream obj(obj_path);
+    obj << "mtllib " << name << ".mtl\n";
+    for (long z = 0; z <= side; z++) {
+        for (long x = 0; x <= side; x++) {
+            obj << "v " << x << " " << std::sin(x * 0.1) * std::cos(z * 0.1) << " " << z << "\n";
+            obj << "vt " << (float)x / side << " " << (float)z / side << "\n";
+        }
+    }
+    obj << "vn 0 1 0\n";
+    long per_group = std::max(1L, side / std::max(1L, materials));
+    for (long z = 0; z < side; z++) {
+        if (z % per_group == 0) {
+            obj << "g strip" << z << "\nusemtl mat" << std::min(materials - 1, z / per_group) << "\n";
+        }
+        for (long x = 0; x < side; x++) {
+            long a = z * (side + 1) + x + 1, b = a + 1, c = a + side + 2, d = a + side + 1;
+            obj << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 " << c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+        }
+    }
+    return obj_path.string();
+}
+
+std::string make_mtl(long materials) {
+    fs::path path = scratch_dir() / ("materials_" + std::to_string(materials) + ".mtl");
+    if (fs::exists(path)) return path.string();
+    std::ofstream mtl(path);
+    for (long m = 0; m < materials; m++) {
+        mtl << "newmtl mat" << m << "\nKa 0.2 0.2 0.2\nKd 0.8 0.5 0.3\nKs 1 1 1\nNs 32\nd 1\nillum 2\n\n";
+    }
+    return path.string();
+}
+
+// Noisy closed loop, like a hand-drawn track
+std::vector<glm::vec2> make_track_points(long count, unsigned seed = 1) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> noise(-0.1f, 0.1f);
+    float radius = 10.0f * count / glm::radians(360.0f);
+    std::vector<glm::vec2> points;
+    for (long i = 0; i < count; i++) {
+        float angle = glm::radians(360.0f) * i / count;
+        points.push_back(glm::vec2(std::cos(angle), std::sin(angle)) * radius * (1.0f + noise(rng)));
+    }
+    return points;
+}
+
+std::vector<glm::vec3> make_keyframes(long count) {
+    std::vector<glm::vec3> keyframes;
+    for (const auto& point : make_track_points(count)) {
+        keyframes.push_back(glm::vec3(point.x, 0.0f, point.y));
+    }
+    return keyframes;
+}
+
+// Linear-scan reference for Animation lookups: the last keyframe whose time is
+// at or before the wrapped time, interpolated towards the next one
+glm::vec3 reference_position(const Animation& animation, const std::vector<float>& times, float time) {
+    float span = times.back() - times.front();
+    float t = animation.looping ? std::fmod(time, span) : glm::clamp(time, 0.0f, span);
+    if (t < 0.0f) t += span;
+    t += times.front();
+    size_t i = 0;
+    while (i + 2 < times.size() && times[i + 1] <= t) i++;
+    float f = glm::clamp((t - times[i]) / (times[i + 1] - times[i]), 0.0f, 1.0f);
+    return glm::mix(animation.keyframes[i], animation.keyframes[i + 1], f);
+}
+
+// Compares get_position_at_time and sample, with and without a cursor, to the
+// reference at every time; returns the number of mismatches
+size_t verify_lookups(const Animation& animation, const std::vector<float>& times, const std::vector<float>& queries,
+                      bool keep_cursor) {
+    size_t mismatches = 0, cursor = 0, sample_cursor = 0;
+    for (float time : queries) {
+        glm::vec3 expected = reference_position(animation, times, time);
+        float tolerance = 1e-4f * std::max(1.0f, glm::length(expected));
+        if (!keep_cursor) cursor = sample_cursor = 0;
+        glm::vec3 searched = animation.get_position_at_time(time);
+        glm::vec3 cached = animation.get_position_at_time(time, &cursor);
+        glm::vec3 sampled = animation.sample(time, &sample_cursor).position;
+        mismatches += glm::length(searched - expected) > tolerance;
+        mismatches += glm::length(cached - expected) > tolerance;
+        mismatches += glm::length(sampled - expected) > tolerance;
+    }
+    return mismatches;
+}
+
+// Unit boxes scattered over a square of the given side
+std::vector<std::shared_ptr<Obj3D>> make_objects(long count, float side, unsigned seed = 1) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-side * 0.5f, side * 0.5f);
+    std::vector<std::shared_ptr<Obj3D>> objects;
+    for (long i = 0; i < count; i++) {
+        auto obj = std::make_shared<Obj3D>();
+        obj->collidable = true;
+        obj->eliminable = false;
+        obj->bbox->min = glm::vec3(-0.5f);
+        obj->bbox->max = glm::vec3(0.5f);
+        obj->has_bounds = true;
+        obj->transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), 0.0f, position(rng)));
+        objects.push_back(obj);
+    }
+    return objects;
+}
+
+// ---- cases ----
+
+void register_cases() {
+    add_case("obj_load_from_file", {1000, 10000, 100000}, [](BenchContext& ctx) {
+        std::string path = make_obj(ctx.arg, 4);
+        ctx.items_per_op = ctx.arg;
+        ctx.run([&] { do_not_optimize(Obj3DWriter::load_from_file(path)); });
+    });
+
+    add_case("obj_load_materials", {10, 100, 1000}, [](BenchContext& ctx) {
+        std::string path = make_mtl(ctx.arg);
+        ctx.items_per_op = ctx.arg;
+        ctx.run([&] { do_not_optimize(Obj3DWriter::load_materials(path)); });
+    });
+
+    add_case("mesh_process_data", {1000, 10000, 100000}, [](BenchContext& ctx) {
+        auto mesh = Obj3DWriter::load_from_file(make_obj(ctx.arg, 4));
+        ctx.items_per_op = ctx.arg;
+        ctx.run([&] { mesh->process_data(); });
+    });
+
+    add_case("obj_setup_buffers_cpu", {1000, 10000, 100000}, [](BenchContext& ctx) {
+        Obj3D obj;
+        obj.mesh = Obj3DWriter::load_from_file(make_obj(ctx.arg, 4));
+        ctx.items_per_op = ctx.arg;
+        ctx.run([&] {
+            obj.buffers_created = false;
+            for (auto& group : obj.mesh->groups) group->dirty = true;
+            obj.setup_buffers();
+        });
+    });
+
+    add_case("bspline_evaluate_curve", {16, 256, 4096}, [](BenchContext& ctx) {
+        BSpline spline;
+        for (const auto& point : make_keyframes(ctx.arg)) spline.addControlPoint(point);
+        std::vector<glm::vec3> samples;
+        spline.evaluateCurve(samples);
+        ctx.items_per_op = samples.size();
+        ctx.run([&] {
+            spline.evaluateCurve(samples);
+            do_not_optimize(samples);
+        });
+    });
+
+    add_case("track_generate_full", {16, 128, 1024}, [](BenchContext& ctx) {
+        TrackEditor editor;
+        editor.set_control_points(make_track_points(ctx.arg));
+        auto mesh = std::make_shared<Mesh>();
+        ctx.run([&] {
+            editor.invalidate_layout();
+            editor.generate_track_mesh(mesh);
+        });
+    });
+
+    add_case("track_generate_drag", {128, 1024, 8192}, [](BenchContext& ctx) {
+        TrackEditor editor;
+        auto points = make_track_points(ctx.arg);
+        editor.set_control_points(points);
+        auto mesh = std::make_shared<Mesh>();
+        editor.generate_track_mesh(mesh);
+        size_t index = ctx.arg / 2;
+        float offset = 0.0f;
+        ctx.run([&] {
+            offset = offset > 0.5f ? 0.0f : offset + 0.01f;
+            editor.move_control_point(index, points[index] + glm::vec2(offset, 0.0f));
+            editor.generate_track_mesh(mesh);
+        });
+    });
+
+    // Self-verifying: picking the way main does it, one grid lookup per elevation in use,
+    // after inserts, removals and elevation edits, against a linear scan; arg: control points
+    add_case("track_pick_point", {1000, 100000}, [](BenchContext& ctx) {
+        TrackEditor editor;
+        auto points = make_track_points(ctx.arg);
+        editor.set_control_points(points);
+        for (size_t i = 0; i < points.size(); i += 7) {
+            TrackPointAttributes attributes = editor.point_attributes[i];
+            attributes.elevation = static_cast<float>(i % 4);
+            editor.set_point_attributes(i, attributes);
+        }
+        for (size_t i = 1; i < 8; i++) {
+            size_t index = i * points.size() / 8;
+            editor.insert_control_point(index, points[index] + glm::vec2(0.5f, 0.0f));
+            editor.remove_control_point(index / 2);
+        }
+
+        const float radius = 2.0f;
+        auto nearest_distance = [&](const glm::vec2& query, int index) {
+            return index < 0 ? -1.0f : glm::length(editor.control_points[index] - query);
+        };
+        bool ok = true;
+        for (size_t i = 0; i < editor.control_points.size(); i += editor.control_points.size() / 64 + 1) {
+            glm::vec2 query = editor.control_points[i] + glm::vec2(0.3f, -0.2f);
+            for (float elevation : editor.elevation_levels()) {
+                int expected = -1;
+                float best = radius * radius;
+                for (size_t j = 0; j < editor.control_points.size(); j++) {
+                    if (editor.point_attributes[j].elevation != elevation) continue;
+                    glm::vec2 d = editor.control_points[j] - query;
+                    if (glm::dot(d, d) <= best) {
+                        best = glm::dot(d, d);
+                        expected = static_cast<int>(j);
+                    }
+                }
+                int picked = editor.nearest_control_point(query, radius, elevation);
+                ok = ok && nearest_distance(query, picked) == nearest_distance(query, expected);
+            }
+        }
+        ctx.check(ok, "picked control points match a linear scan");
+
+        size_t next = 0;
+        ctx.run([&] {
+            next = (next + 101) % editor.control_points.size();
+            glm::vec2 query = editor.control_points[next] + glm::vec2(0.3f, -0.2f);
+            int best = -1;
+            for (float elevation : editor.elevation_levels()) {
+                int picked = editor.nearest_control_point(query, radius, elevation);
+                if (picked >= 0) best = picked;
+            }
+            do_not_optimize(best);
+        });
+    });
+
+    add_case("track_export_obj", {16, 128, 1024}, [](BenchContext& ctx) {
+        TrackEditor editor;
+        editor.set_control_points(make_track_points(ctx.arg));
+        std::string path = (scratch_dir() / "export.obj").string();
+        ctx.run([&] { do_not_optimize(editor.export_track_OBJ(path)); });
+    });
+
+    // Self-verifying: the mesh cached in a saved track document, mapped back through
+    // load_geometry, against the triangles of the exported OBJ; arg: control points
+    add_case("track_document_roundtrip", {16, 128}, [](BenchContext& ctx) {
+        // Keeps the vertices load_geometry uploads so they can be compared
+        struct CaptureDevice : NullRenderDevice {
+            std::vector<float> uploaded;
+            void upload_group(Group& group, const float* interleaved_data, size_t vertex_count) override {
+                uploaded.assign(interleaved_data, interleaved_data + vertex_count * 8);
+                NullRenderDevice::upload_group(group, interleaved_data, vertex_count);
+            }
+        };
+        auto device = std::make_unique<CaptureDevice>();
+        CaptureDevice& capture = *device;
+        RenderDevice::set_current(std::move(device));
+
+        TrackEditor editor;
+        editor.set_control_points(make_track_points(ctx.arg));
+        std::string document = (scratch_dir() / "roundtrip.rtrk").string();
+        std::string obj_file = (scratch_dir() / "roundtrip.obj").string();
+        editor.export_track_OBJ(obj_file);
+        auto exported = Obj3DWriter::load_from_file(obj_file);
+        auto cached = std::make_shared<Obj3D>();
+        ctx.check(TrackDocument::save(document, editor) && TrackDocument::load_geometry(document, cached),
+                  "track document save and load_geometry");
+
+        const auto& expected = exported->processed_verts;
+        ctx.check(capture.uploaded.size() == expected.size() * 8, "cached vertex count matches the exported OBJ");
+        size_t mismatches = 0;
+        for (size_t i = 0; i < expected.size() && (i + 1) * 8 <= capture.uploaded.size(); i++) {
+            glm::vec3 position(capture.uploaded[i * 8], capture.uploaded[i * 8 + 1], capture.uploaded[i * 8 + 2]);
+            mismatches += glm::length(position - expected[i]) > 1e-3f * std::max(1.0f, glm::length(expected[i]));
+        }
+        ctx.check(mismatches == 0, "cached positions match the exported OBJ, arg " + std::to_string(ctx.arg));
+
+        ctx.run([&] {
+            TrackDocument::save(document, editor);
+            do_not_optimize(TrackDocument::load_geometry(document, cached));
+        });
+        RenderDevice::set_current(std::make_unique<NullRenderDevice>());
+    });
+
+    // arg: 0 linear, 1 constant speed, 2 timestamps with a cursor, 3 timestamps without
+    add_case("animation_position_at_time", {0, 1, 2, 3}, [](BenchContext& ctx) {
+        Animation animation;
+        animation.keyframes = make_keyframes(10000);
+        if (ctx.arg == 1) {
+            animation.constant_speed = true;
+            animation.build_arc_length_table();
+        }
+        if (ctx.arg >= 2) {
+            std::mt19937 rng(1);
+            std::uniform_real_distribution<float> gap(0.005f, 0.02f);
+            float time = 0.0f;
+            for (size_t i = 0; i < animation.keyframes.size(); i++) {
+                animation.timestamps.push_back(time);
+                time += gap(rng);
+            }
+            animation.prepare_timestamps();
+        }
+        size_t cursor = 0;
+        float time = 0.0f, step = animation.duration / 7919.0f;
+        ctx.run([&] {
+            time += step;
+            do_not_optimize(animation.get_position_at_time(time, ctx.arg == 3 ? nullptr : &cursor));
+        });
+    });
+
+    // Self-verifying: lookups against a linear scan over the keyframe times.
+    // arg: 0 no timestamps (uniform), 1 evenly spaced timestamps (uniform), 2 uneven (searched)
+    add_case("animation_lookup_check", {0, 1, 2}, [](BenchContext& ctx) {
+        Animation animation;
+        animation.keyframes = make_keyframes(1000);
+        std::vector<float> times;
+        std::mt19937 rng(ctx.arg + 1);
+        std::uniform_real_distribution<float> gap(0.005f, 0.02f);
+        for (size_t i = 0; i < animation.keyframes.size(); i++) {
+            float step = animation.duration / (animation.keyframes.size() - 1);
+            times.push_back(ctx.arg == 2 ? (times.empty() ? 0.5f : times.back() + gap(rng)) : step * i);
+        }
+        // The uniform path wraps at duration itself
+        if (ctx.arg < 2) times.back() = animation.duration;
+        if (ctx.arg > 0) {
+            animation.timestamps = times;
+            animation.prepare_timestamps();
+            ctx.check(animation.has_timestamps() == (ctx.arg == 2), "lookup strategy picked by prepare_timestamps");
+        }
+
+        // Three laps forward in small steps (the cursor wraps twice), then random times around them
+        std::vector<float> monotonic, random;
+        for (float time = 0.0f; time < animation.duration * 3.0f; time += animation.duration / 997.0f) {
+            monotonic.push_back(time);
+        }
+        std::uniform_real_distribution<float> anywhere(-animation.duration, animation.duration * 3.0f);
+        for (int i = 0; i < 1000; i++) {
+            random.push_back(anywhere(rng));
+        }
+        ctx.check(verify_lookups(animation, times, monotonic, true) == 0, "monotonic lookups, arg " + std::to_string(ctx.arg));
+        ctx.check(verify_lookups(animation, times, random, true) == 0, "random lookups, arg " + std::to_string(ctx.arg));
+        ctx.check(verify_lookups(animation, times, random, false) == 0, "random lookups from a fresh cursor, arg " + std::to_string(ctx.arg));
+
+        ctx.items_per_op = monotonic.size();
+        ctx.run([&] { do_not_optimize(verify_lookups(animation, times, monotonic, true)); });
+    });
+
+    // arg: bullets, against 100 collidable objects
+    add_case("bullets_update_collide", {100, 1000, 10000}, [](BenchContext& ctx) {
+        auto objects = make_objects(100, 200.0f);
+        BulletManager manager;
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+        ctx.items_per_op = ctx.arg;
+        ctx.run([&] {
+            while ((long)manager.bullets.size() < ctx.arg) {
+                manager.addBullet(glm::vec3(coordinate(rng), 0.0f, coordinate(rng)),
+                                  glm::vec3(coordinate(rng), 0.0f, coordinate(rng)) + glm::vec3(0.001f));
+            }
+            manager.update(1.0f / 60.0f);
+            manager.checkCollisions(objects);
+        });
+    });
+
+    add_case("bbox_ray", {0}, [](BenchContext& ctx) {
+        BoundingBox box;
+        box.min = glm::vec3(-1.0f);
+        box.max = glm::vec3(1.0f);
+        glm::vec3 origin(-5.0f, 0.3f, 0.2f), direction = glm::normalize(glm::vec3(1.0f, 0.01f, 0.02f));
+        ctx.run([&] {
+            float t = 0.0f;
+            do_not_optimize(box.intersects_ray(origin, direction, t));
+            do_not_optimize(t);
+        });
+    });
+
+    add_case("bbox_box", {0}, [](BenchContext& ctx) {
+        auto a = std::make_shared<BoundingBox>(), b = std::make_shared<BoundingBox>();
+        a->min = glm::vec3(-1.0f);
+        a->max = glm::vec3(1.0f);
+        b->min = glm::vec3(0.5f);
+        b->max = glm::vec3(2.0f);
+        ctx.run([&] { do_not_optimize(a->intersects(b)); });
+    });
+
+    add_case("frustum_cull_objects", {1000, 10000, 100000}, [](BenchContext& ctx) {
+        auto objects = make_objects(ctx.arg, 600.0f);
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 1000.0f);
+        Frustum frustum;
+        frustum.extract(projection * view);
+        ctx.items_per_op = ctx.arg;
+        ctx.run([&] {
+            size_t visible = 0;
+            for (const auto& obj : objects) visible += frustum.intersects(obj->get_world_bounds());
+            do_not_optimize(visible);
+        });
+    });
+
+    // The root of arg children moves every op, so every node is recomputed
+    add_case("hierarchy_update_wide", {1000, 100000}, [](BenchContext& ctx) {
+        TransformHierarchy hierarchy;
+        uint32_t root = hierarchy.add_node();
+        for (long i = 0; i < ctx.arg; i++) {
+            hierarchy.add_node(glm::translate(glm::mat4(1.0f), glm::vec3((float)i, 0.0f, 0.0f)), root);
+        }
+        float x = 0.0f;
+        ctx.items_per_op = ctx.arg;
+        ctx.run([&] {
+            hierarchy.set_local(root, glm::translate(glm::mat4(1.0f), glm::vec3(x += 0.01f, 0.0f, 0.0f)));
+            do_not_optimize(hierarchy.update(0));
+        });
+    });
+
+    // One chain arg nodes deep, moved at the root
+    add_case("hierarchy_update_deep", {100, 10000}, [](BenchContext& ctx) {
+        TransformHierarchy hierarchy;
+        uint32_t root = hierarchy.add_node();
+        for (long i = 0, parent = root; i < ctx.arg; i++) {
+            parent = hierarchy.add_node(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 1.0f)), (uint32_t)parent);
+        }
+        float x = 0.0f;
+        ctx.items_per_op = ctx.arg;
+        ctx.run([&] {
+            hierarchy.set_local(root, glm::translate(glm::mat4(1.0f), glm::vec3(x += 0.01f, 0.0f, 0.0f)));
+            do_not_optimize(hierarchy.update(0));
+        });
+    });
+
+    // 1000 cars with arg attached parts each; one car moves per op, the rest stay clean
+    add_case("hierarchy_update_sparse", {4, 100}, [](BenchContext& ctx) {
+        TransformHierarchy hierarchy;
+        std::vector<uint32_t> roots;
+        for (int car = 0; car < 1000; car++) {
+            roots.push_back(hierarchy.add_node());
+            for (long i = 0; i < ctx.arg; i++) {
+                hierarchy.add_node(glm::translate(glm::mat4(1.0f), glm::vec3((float)i, 0.0f, 0.0f)), roots.back());
+            }
+        }
+        hierarchy.update();
+        size_t next = 0;
+        ctx.run([&] {
+            uint32_t root = roots[next++ % roots.size()];
+            hierarchy.set_local(root, glm::translate(hierarchy.locals[root], glm::vec3(0.01f, 0.0f, 0.0f)));
+            do_not_optimize(hierarchy.update(0));
+        });
+    });
+
+    // Scene stage of the case above: one car with four attached parts moves per frame
+    // and its worlds are written back to the entities; arg: scene size
+    add_case("scene_update_hierarchy", {1000, 100000}, [](BenchContext& ctx) {
+        auto objects = make_objects(ctx.arg, 600.0f);
+        Scene scene;
+        for (const auto& obj : objects) scene.add_object(obj);
+        std::vector<uint32_t> cars;
+        for (size_t i = 0; i + 4 < objects.size(); i += 5) {
+            cars.push_back(scene.index_of(objects[i]->scene_handle));
+            for (size_t part = 1; part <= 4; part++) {
+                scene.attach(objects[i + part]->scene_handle, objects[i]->scene_handle,
+                             glm::translate(glm::mat4(1.0f), glm::vec3((float)part, 0.0f, 0.0f)));
+            }
+        }
+        scene.update_hierarchy();
+        size_t next = 0;
+        ctx.run([&] {
+            uint32_t car = cars[next++ % cars.size()];
+            scene.set_transform(car, glm::translate(scene.transforms[car], glm::vec3(0.01f, 0.0f, 0.0f)));
+            scene.update_hierarchy();
+        });
+    });
+
+    // Removes a random entity and adds it back; arg: scene size
+    add_case("scene_remove_add", {1000, 100000}, [](BenchContext& ctx) {
+        auto objects = make_objects(ctx.arg, 600.0f);
+        Scene scene;
+        for (const auto& obj : objects) scene.add_object(obj);
+        std::mt19937 rng(1);
+        std::uniform_int_distribution<size_t> pick(0, objects.size() - 1);
+        ctx.run([&] {
+            const auto& obj = objects[pick(rng)];
+            scene.remove_object(obj->scene_handle);
+            scene.add_object(obj);
+        });
+    });
+
+    // One frame of a 100k-entity scene: move 1% of the entities, cull, collide
+    // 16 bullets and compact. arg 0 walks a vector<shared_ptr<Obj3D>> the way
+    // the scene used to, arg 1 the Scene component arrays.
+    add_case("scene_frame_layout", {0, 1}, [](BenchContext& ctx) {
+        const long entities = 100000;
+        auto objects = make_objects(entities, 600.0f);
+        Scene scene;
+        if (ctx.arg == 1) {
+            for (const auto& obj : objects) scene.add_object(obj);
+        }
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 1000.0f);
+        Frustum frustum;
+        frustum.extract(projection * view);
+        BulletManager manager;
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> coordinate(-300.0f, 300.0f);
+        for (int i = 0; i < 16; i++) {
+            manager.addBullet(glm::vec3(coordinate(rng), 0.0f, coordinate(rng)), glm::vec3(1.0f, 0.0f, 0.0f));
+        }
+        size_t next = 0;
+        ctx.items_per_op = entities;
+        ctx.run([&] {
+            for (long i = 0; i < entities / 100; i++) {
+                Obj3D& obj = *objects[next];
+                next = (next + 7919) % entities;
+                glm::mat4 transform = glm::translate(obj.transform, glm::vec3(0.01f, 0.0f, 0.0f));
+                if (ctx.arg == 0) obj.transform = transform;
+                else obj.set_transform(transform);
+            }
+            size_t visible = 0;
+            if (ctx.arg == 0) {
+                for (const auto& obj : objects) {
+                    visible += obj->active && obj->has_bounds && frustum.intersects(obj->get_world_bounds());
+                }
+                manager.checkCollisions(objects);
+                objects.erase(std::remove_if(objects.begin(), objects.end(),
+                                             [](const std::shared_ptr<Obj3D>& obj) { return !obj->active; }),
+                              objects.end());
+            } else {
+                scene.update_bounds();
+                for (size_t i = 0; i < scene.size(); i++) {
+                    visible += (scene.flags[i] & (Scene::ACTIVE | Scene::HAS_BOUNDS)) == (Scene::ACTIVE | Scene::HAS_BOUNDS) &&
+                               frustum.intersects(scene.world_bounds[i].min, scene.world_bounds[i].max);
+                }
+                manager.checkCollisions(scene);
+                scene.update();
+            }
+            do_not_optimize(visible);
+        });
+    });
+}
+
+int main(int argc, char** argv) {
+    std::string filter, json_file, baseline_file;
+    double min_time = 0.2, threshold = 0.15;
+    int repeats = 5;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--filter") filter = argv[i + 1];
+        else if (arg == "--min-time") min_time = std::atof(argv[i + 1]);
+        else if (arg == "--repeats") repeats = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--json") json_file = argv[i + 1];
+        else if (arg == "--baseline") baseline_file = argv[i + 1];
+        else if (arg == "--threshold") threshold = std::atof(argv[i + 1]);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    RenderDevice::set_current(std::make_unique<NullRenderDevice>());
+    register_cases();
+    std::map<std::string, double> baseline;
+    if (!baseline_file.empty()) {
+        baseline = read_baseline(baseline_file);
+        if (baseline.empty()) {
+            std::cerr << "Warning: no entries read from baseline " << baseline_file << std::endl;
+        }
+    }
+
+    // Loader messages would interleave with the table
+    std::ostringstream discarded;
+    std::streambuf* stdout_buffer = std::cout.rdbuf();
+
+    std::vector<std::pair<std::string, double>> results;
+    int regressions = 0, failures = 0;
+    printf("%-40s %14s %14s %10s\n", "case", "ns/op", "items/s", "vs base");
+    for (const auto& bench : bench_cases()) {
+        for (long arg : bench.args) {
+            std::string name = bench.name + "/" + std::to_string(arg);
+            if (!filter.empty() && name.find(filter) == std::string::npos) continue;
+
+            BenchContext ctx;
+            ctx.arg = arg;
+            ctx.min_time = min_time;
+            ctx.repeats = repeats;
+            std::cout.rdbuf(discarded.rdbuf());
+            bench.fn(ctx);
+            std::cout.rdbuf(stdout_buffer);
+            discarded.str("");
+            results.push_back({name, ctx.ns_per_op});
+            failures += ctx.failures;
+
+            char versus[32] = "";
+            auto base = baseline.find(name);
+            if (base != baseline.end() && base->second > 0.0) {
+                double ratio = ctx.ns_per_op / base->second;
+                snprintf(versus, sizeof(versus), "%+.1f%%%s", (ratio - 1.0) * 100.0, ratio > 1.0 + threshold ? " !" : "");
+                if (ratio > 1.0 + threshold) regressions++;
+            }
+            printf("%-40s %14.1f %14.3g %10s\n", name.c_str(), ctx.ns_per_op,
+                   ctx.items_per_op * 1e9 / ctx.ns_per_op, versus);
+            fflush(stdout);
+        }
+    }
+
+    if (!json_file.empty()) {
+        write_results(json_file, results);
+    }
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    if (regressions > 0) {
+        printf("%d case(s) slower than baseline by more than %.0f%%\n", regressions, threshold * 100.0);
+        return 1;
+    }
+    return 0;
+}